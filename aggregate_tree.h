@@ -0,0 +1,605 @@
+#ifndef AGGREGATE_TREE_H
+#define AGGREGATE_TREE_H
+
+#include <iostream>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "avlbst.h"
+
+// An AVLTree whose nodes also store an aggregate of their whole subtree,
+// so that the aggregate of any key range comes out of O(log n) nodes.
+//
+// The aggregate is described by a monoid, a struct with
+//   typedef ... type;
+//   static type identity();
+//   static type of(const Key& key, const Value& value);
+//   static type combine(const type& a, const type& b);
+// where combine is associative and identity is its neutral element.
+// combine need not be commutative: ranges are always combined in key order.
+// Sum, count, min and max are provided below.
+
+/**
+ * Sum of the values.
+ */
+template <typename Key, typename Value>
+struct SumMonoid
+{
+    typedef Value type;
+    static type identity() { return Value(); }
+    static type of(const Key&, const Value& value) { return value; }
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+/**
+ * Number of items.
+ */
+template <typename Key, typename Value>
+struct CountMonoid
+{
+    typedef std::size_t type;
+    static type identity() { return 0; }
+    static type of(const Key&, const Value&) { return 1; }
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+/**
+ * Smallest value; numeric_limits<Value>::max() for an empty range.
+ */
+template <typename Key, typename Value>
+struct MinMonoid
+{
+    typedef Value type;
+    static type identity() { return std::numeric_limits<Value>::max(); }
+    static type of(const Key&, const Value& value) { return value; }
+    static type combine(const type& a, const type& b) { return (b < a) ? b : a; }
+};
+
+/**
+ * Largest value; numeric_limits<Value>::lowest() for an empty range.
+ */
+template <typename Key, typename Value>
+struct MaxMonoid
+{
+    typedef Value type;
+    static type identity() { return std::numeric_limits<Value>::lowest(); }
+    static type of(const Key&, const Value& value) { return value; }
+    static type combine(const type& a, const type& b) { return (a < b) ? b : a; }
+};
+
+/**
+* An AVLNode that also stores the aggregate of its subtree.
+*/
+template <typename Key, typename Value, typename Monoid>
+class AggregateNode : public AVLNode<Key, Value>
+{
+public:
+    typedef typename Monoid::type aggregate_type;
+
+    AggregateNode(const Key& key, const Value& value, AggregateNode<Key, Value, Monoid>* parent);
+    virtual ~AggregateNode();
+
+    const aggregate_type& getAggregate() const;
+    void setAggregate(const aggregate_type& aggregate);
+    void updateAggregate();
+
+    virtual AggregateNode<Key, Value, Monoid>* getParent() const override;
+    virtual AggregateNode<Key, Value, Monoid>* getLeft() const override;
+    virtual AggregateNode<Key, Value, Monoid>* getRight() const override;
+
+    // aggregate of a possibly empty subtree
+    static aggregate_type aggregateOf(const AggregateNode<Key, Value, Monoid>* n);
+
+protected:
+    aggregate_type aggregate_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AggregateNode class.
+  -------------------------------------------------
+*/
+
+/**
+* A new node is a leaf, so its aggregate covers only its own item.
+*/
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>::AggregateNode(const Key& key, const Value& value,
+                                                 AggregateNode<Key, Value, Monoid>* parent) :
+    AVLNode<Key, Value>(key, value, parent), aggregate_(Monoid::of(key, value))
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>::~AggregateNode()
+{
+
+}
+
+/**
+* The aggregate of this node's subtree.
+*/
+template<class Key, class Value, class Monoid>
+const typename AggregateNode<Key, Value, Monoid>::aggregate_type&
+AggregateNode<Key, Value, Monoid>::getAggregate() const
+{
+    return aggregate_;
+}
+
+/**
+* A setter for the aggregate, for copying nodes.
+*/
+template<class Key, class Value, class Monoid>
+void AggregateNode<Key, Value, Monoid>::setAggregate(const aggregate_type& aggregate)
+{
+    aggregate_ = aggregate;
+}
+
+/**
+* Recomputes the aggregate from the children's aggregates and this item,
+* in key order.
+*/
+template<class Key, class Value, class Monoid>
+void AggregateNode<Key, Value, Monoid>::updateAggregate()
+{
+    aggregate_ = Monoid::combine(Monoid::combine(aggregateOf(getLeft()), Monoid::of(this->getKey(), this->getValue())),
+                                 aggregateOf(getRight()));
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateNode<Key, Value, Monoid>::aggregate_type
+AggregateNode<Key, Value, Monoid>::aggregateOf(const AggregateNode<Key, Value, Monoid>* n)
+{
+    return n ? n->aggregate_ : Monoid::identity();
+}
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>* AggregateNode<Key, Value, Monoid>::getParent() const
+{
+    return static_cast<AggregateNode<Key, Value, Monoid>*>(this->parent_);
+}
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>* AggregateNode<Key, Value, Monoid>::getLeft() const
+{
+    return static_cast<AggregateNode<Key, Value, Monoid>*>(this->left_);
+}
+
+template<class Key, class Value, class Monoid>
+AggregateNode<Key, Value, Monoid>* AggregateNode<Key, Value, Monoid>::getRight() const
+{
+    return static_cast<AggregateNode<Key, Value, Monoid>*>(this->right_);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AggregateNode class.
+  -----------------------------------------------
+*/
+
+
+/**
+* An AVLTree that answers "combine the values of every key in [first, last)"
+* in O(log n). The aggregates are kept current by AVLTree's insert, remove,
+* erase and rotations through its augmentation hooks, at O(log n) extra
+* per update.
+*
+* Change values with insert(), upsert() or modify(): iterators and
+* operator[] only give read access, since a value written in place would
+* leave the aggregates above it stale. operator[] is the const one, so it
+* throws std::out_of_range for a missing key instead of inserting it.
+*/
+template <typename Key, typename Value, typename Monoid = SumMonoid<Key, Value> >
+class AggregateAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef typename Monoid::type aggregate_type;
+
+    /**
+    * An AVLTree iterator whose items are read-only
+    */
+    class iterator : public AVLTree<Key, Value>::iterator
+    {
+    public:
+        iterator();
+        iterator(const typename AVLTree<Key, Value>::iterator& it);
+
+        const std::pair<const Key, Value>& operator*() const;
+        const std::pair<const Key, Value>* operator->() const;
+
+        iterator& operator++();
+    };
+
+    typedef typename AVLTree<Key, Value>::node_type node_type;
+
+    AggregateAVLTree();
+    AggregateAVLTree(const AggregateAVLTree<Key, Value, Monoid>& other);
+    virtual void rebalance();
+    aggregate_type aggregate() const;
+    aggregate_type aggregate(const Key& first, const Key& last) const;
+
+    // the AVLTree operations that return iterators, returning read-only ones
+    std::pair<iterator, bool> insert(const std::pair<const Key, Value>& keyValuePair);
+    std::pair<iterator, bool> try_insert(const std::pair<const Key, Value>& keyValuePair);
+    std::pair<iterator, bool> insert(node_type&& handle);
+    std::size_t erase(const Key& first, const Key& last);
+    iterator erase(iterator pos);
+    iterator erase(iterator first, iterator last);
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator find(const Key& key, iterator hint) const;
+    void find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const;
+    iterator min() const;
+    iterator max() const;
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef AggregateNode<Key, Value, Monoid> ANode;
+
+    virtual Node<Key, Value>* createNode(const Key& key, const Value& value, Node<Key, Value>* parent) const;
+    virtual std::size_t nodeBytes() const;
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    virtual bool canCloneFrom(const BinarySearchTree<Key, Value>& other) const;
+    virtual bool canAdopt(const Node<Key, Value>* n) const;
+    virtual Node<Key, Value>* adoptNode(Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    virtual void pathChanged(AVLNode<Key, Value>* n);
+    virtual void rotated(AVLNode<Key, Value>* lower, AVLNode<Key, Value>* upper);
+
+    // Add helper functions here
+    void updateSubtree(ANode* n);
+    ANode* aggregateRoot() const;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the AggregateAVLTree::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, class Monoid>
+AggregateAVLTree<Key, Value, Monoid>::iterator::iterator() :
+    AVLTree<Key, Value>::iterator()
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+AggregateAVLTree<Key, Value, Monoid>::iterator::iterator(const typename AVLTree<Key, Value>::iterator& it) :
+    AVLTree<Key, Value>::iterator(it)
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+const std::pair<const Key, Value>& AggregateAVLTree<Key, Value, Monoid>::iterator::operator*() const
+{
+    return AVLTree<Key, Value>::iterator::operator*();
+}
+
+template<class Key, class Value, class Monoid>
+const std::pair<const Key, Value>* AggregateAVLTree<Key, Value, Monoid>::iterator::operator->() const
+{
+    return AVLTree<Key, Value>::iterator::operator->();
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator&
+AggregateAVLTree<Key, Value, Monoid>::iterator::operator++()
+{
+    AVLTree<Key, Value>::iterator::operator++();
+    return *this;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AggregateAVLTree::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value, class Monoid>
+AggregateAVLTree<Key, Value, Monoid>::AggregateAVLTree() :
+    AVLTree<Key, Value>()
+{
+
+}
+
+/*
+ * Copies other node for node, aggregates included (see AVLTree's copy
+ * constructor)
+ */
+template<class Key, class Value, class Monoid>
+AggregateAVLTree<Key, Value, Monoid>::AggregateAVLTree(const AggregateAVLTree<Key, Value, Monoid>& other) :
+    AVLTree<Key, Value>()
+{
+    this->assign(other);
+}
+
+/*
+ * The aggregate of the whole tree, identity() when empty
+ */
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::aggregate_type
+AggregateAVLTree<Key, Value, Monoid>::aggregate() const
+{
+    return ANode::aggregateOf(aggregateRoot());
+}
+
+/*
+ * The aggregate of the values of the keys k with first <= k < last, in
+ * key order. Descends to the highest node inside the range, then follows
+ * the two range bounds down from there: every subtree hanging inside the
+ * range is taken whole from its stored aggregate, so this is O(log n).
+ */
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::aggregate_type
+AggregateAVLTree<Key, Value, Monoid>::aggregate(const Key& first, const Key& last) const
+{
+    if (!(first < last)) return Monoid::identity();
+
+    // highest node in the range: the two bounds part ways below it
+    ANode* top = aggregateRoot();
+    while (top){
+        BST_STAT((++this->stats_.nodesVisited, ++this->stats_.comparisons));
+        if (top->getKey() < first) top = top->getRight();
+        else if (!(top->getKey() < last)) top = top->getLeft();
+        else break;
+    }
+    if (!top) return Monoid::identity();
+
+    // keys >= first in the left subtree; each part found lies before the previous ones
+    aggregate_type below = Monoid::identity();
+    ANode* n = top->getLeft();
+    while (n){
+        BST_STAT((++this->stats_.nodesVisited, ++this->stats_.comparisons));
+        if (n->getKey() < first){
+            n = n->getRight();
+        }
+        else {
+            below = Monoid::combine(Monoid::combine(Monoid::of(n->getKey(), n->getValue()),
+                                                    ANode::aggregateOf(n->getRight())), below);
+            n = n->getLeft();
+        }
+    }
+
+    // keys < last in the right subtree; each part found lies after the previous ones
+    aggregate_type above = Monoid::identity();
+    n = top->getRight();
+    while (n){
+        BST_STAT((++this->stats_.nodesVisited, ++this->stats_.comparisons));
+        if (n->getKey() < last){
+            above = Monoid::combine(above, Monoid::combine(ANode::aggregateOf(n->getLeft()),
+                                                           Monoid::of(n->getKey(), n->getValue())));
+            n = n->getRight();
+        }
+        else {
+            n = n->getLeft();
+        }
+    }
+
+    return Monoid::combine(Monoid::combine(below, Monoid::of(top->getKey(), top->getValue())), above);
+}
+
+/*
+ * The AVLTree operations below only change the iterator type they return
+ */
+template<class Key, class Value, class Monoid>
+std::pair<typename AggregateAVLTree<Key, Value, Monoid>::iterator, bool>
+AggregateAVLTree<Key, Value, Monoid>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    std::pair<typename AVLTree<Key, Value>::iterator, bool> result = AVLTree<Key, Value>::insert(keyValuePair);
+    return std::make_pair(iterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Monoid>
+std::pair<typename AggregateAVLTree<Key, Value, Monoid>::iterator, bool>
+AggregateAVLTree<Key, Value, Monoid>::try_insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    std::pair<typename AVLTree<Key, Value>::iterator, bool> result = AVLTree<Key, Value>::try_insert(keyValuePair);
+    return std::make_pair(iterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Monoid>
+std::pair<typename AggregateAVLTree<Key, Value, Monoid>::iterator, bool>
+AggregateAVLTree<Key, Value, Monoid>::insert(node_type&& handle)
+{
+    std::pair<typename AVLTree<Key, Value>::iterator, bool> result = AVLTree<Key, Value>::insert(std::move(handle));
+    return std::make_pair(iterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Monoid>
+std::size_t AggregateAVLTree<Key, Value, Monoid>::erase(const Key& first, const Key& last)
+{
+    return AVLTree<Key, Value>::erase(first, last);
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::erase(iterator pos)
+{
+    return AVLTree<Key, Value>::erase(pos);
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::erase(iterator first, iterator last)
+{
+    return AVLTree<Key, Value>::erase(first, last);
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::begin() const
+{
+    return AVLTree<Key, Value>::begin();
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::end() const
+{
+    return AVLTree<Key, Value>::end();
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::find(const Key& key) const
+{
+    return AVLTree<Key, Value>::find(key);
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::find(const Key& key, iterator hint) const
+{
+    return AVLTree<Key, Value>::find(key, hint);
+}
+
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const
+{
+    std::vector<typename AVLTree<Key, Value>::iterator> found;
+    AVLTree<Key, Value>::find_batch(keys, found);
+    out.assign(found.begin(), found.end());
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::min() const
+{
+    return AVLTree<Key, Value>::min();
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::iterator
+AggregateAVLTree<Key, Value, Monoid>::max() const
+{
+    return AVLTree<Key, Value>::max();
+}
+
+/*
+ * Read-only lookup, throws std::out_of_range if key is missing (see the
+ * class comment)
+ */
+template<class Key, class Value, class Monoid>
+Value const & AggregateAVLTree<Key, Value, Monoid>::operator[](const Key& key) const
+{
+    return AVLTree<Key, Value>::operator[](key);
+}
+
+/*
+ * Rebuilds the tree (see AVLTree::rebalance), then recomputes every
+ * aggregate for the new shape
+ */
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::rebalance()
+{
+    AVLTree<Key, Value>::rebalance();
+    updateSubtree(aggregateRoot());
+}
+
+/*
+ * rebalance() helper function
+ * recomputes the aggregates of n's subtree bottom-up
+ */
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::updateSubtree(ANode* n)
+{
+    if (!n) return;
+    updateSubtree(n->getLeft());
+    updateSubtree(n->getRight());
+    n->updateAggregate();
+}
+
+/*
+ * Augmentation hook: recompute n and every ancestor up to the root of its
+ * (possibly detached) subtree
+ */
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::pathChanged(AVLNode<Key, Value>* n)
+{
+    for (ANode* curr = static_cast<ANode*>(n); curr; curr = curr->getParent()){
+        curr->updateAggregate();
+    }
+}
+
+/*
+ * Augmentation hook: only the two rotated nodes cover a different set of
+ * items, and lower is now upper's child, so it goes first
+ */
+template<class Key, class Value, class Monoid>
+void AggregateAVLTree<Key, Value, Monoid>::rotated(AVLNode<Key, Value>* lower, AVLNode<Key, Value>* upper)
+{
+    static_cast<ANode*>(lower)->updateAggregate();
+    static_cast<ANode*>(upper)->updateAggregate();
+}
+
+template<class Key, class Value, class Monoid>
+Node<Key, Value>* AggregateAVLTree<Key, Value, Monoid>::createNode(const Key& key, const Value& value,
+                                                                   Node<Key, Value>* parent) const
+{
+    BST_STAT(++this->stats_.allocations);
+    return new ANode(key, value, static_cast<ANode*>(parent));
+}
+
+template<class Key, class Value, class Monoid>
+std::size_t AggregateAVLTree<Key, Value, Monoid>::nodeBytes() const
+{
+    return sizeof(ANode);
+}
+
+/*
+ * assign() hook: an ANode with n's item, balance and aggregate
+ */
+template<class Key, class Value, class Monoid>
+Node<Key, Value>* AggregateAVLTree<Key, Value, Monoid>::cloneNode(const Node<Key, Value>* n,
+                                                                  Node<Key, Value>* parent) const
+{
+    const ANode* from = static_cast<const ANode*>(n);
+    ANode* copy = new ANode(from->getKey(), from->getValue(), static_cast<ANode*>(parent));
+    copy->setBalance(from->getBalance());
+    copy->setAggregate(from->getAggregate());
+    return copy;
+}
+
+/*
+ * assign() hook: the source needs aggregates of the same monoid
+ */
+template<class Key, class Value, class Monoid>
+bool AggregateAVLTree<Key, Value, Monoid>::canCloneFrom(const BinarySearchTree<Key, Value>& other) const
+{
+    return dynamic_cast<const AggregateAVLTree<Key, Value, Monoid>*>(&other) != nullptr;
+}
+
+/*
+ * Node handle hook: the node needs an aggregate of the same monoid
+ */
+template<class Key, class Value, class Monoid>
+bool AggregateAVLTree<Key, Value, Monoid>::canAdopt(const Node<Key, Value>* n) const
+{
+    return typeid(*n) == typeid(ANode);
+}
+
+/*
+ * Node handle hook: a new leaf's aggregate covers only its own item
+ */
+template<class Key, class Value, class Monoid>
+Node<Key, Value>* AggregateAVLTree<Key, Value, Monoid>::adoptNode(Node<Key, Value>* n,
+                                                                  Node<Key, Value>* parent) const
+{
+    AVLTree<Key, Value>::adoptNode(n, parent);
+    static_cast<ANode*>(n)->updateAggregate();
+    return n;
+}
+
+template<class Key, class Value, class Monoid>
+typename AggregateAVLTree<Key, Value, Monoid>::ANode*
+AggregateAVLTree<Key, Value, Monoid>::aggregateRoot() const
+{
+    return static_cast<ANode*>(this->root_);
+}
+
+#endif
@@ -131,88 +131,135 @@ template <class Key, class Value>
 class AVLTree : public BinarySearchTree<Key, Value>
 {
 public:
-    virtual void insert (const std::pair<const Key, Value> &new_item); // TODO
-    virtual void remove(const Key& key);  // TODO
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+
+    AVLTree();
+    AVLTree(const AVLTree<Key, Value>& other);
+    using BinarySearchTree<Key, Value>::erase;
+    std::size_t erase(const Key& first, const Key& last);
+    iterator erase(iterator first, iterator last);
+    virtual void rebalance();
+    virtual int height() const;
 protected:
     virtual void nodeSwap(AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2);
+    virtual Node<Key, Value>* createNode(const Key& key, const Value& value, Node<Key, Value>* parent) const;
+    virtual Node<Key, Value>* findOrInsert(const Key& key, const Value& value,
+                                           Node<Key, Value>* detached, bool& inserted);
+    virtual void valueChanged(Node<Key, Value>* n);
+    virtual void detachNode(Node<Key, Value>* target);
+    virtual std::size_t nodeBytes() const;
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    virtual bool canCloneFrom(const BinarySearchTree<Key, Value>& other) const;
+    virtual bool canAdopt(const Node<Key, Value>* n) const;
+    virtual Node<Key, Value>* adoptNode(Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    virtual bool checkNode(const Node<Key, Value>* n, int leftHeight, int rightHeight) const;
+
+    // Augmentation hooks for subclasses that keep per-subtree data in their
+    // nodes, no-ops here. pathChanged(n): n's subtree changed, so n and its
+    // ancestors need updating. rotated(lower, upper): a rotation just moved
+    // upper above lower, whose subtrees are otherwise unchanged.
+    virtual void pathChanged(AVLNode<Key, Value>* n);
+    virtual void rotated(AVLNode<Key, Value>* lower, AVLNode<Key, Value>* upper);
 
     // Add helper functions here
-    AVLNode<Key, Value>* getLeaf(const Key& key, AVLNode<Key, Value>* p);
     void insertFix(AVLNode<Key, Value>* p, AVLNode<Key, Value>* n);
     void rotateRight(AVLNode<Key, Value>* parent);
     void rotateLeft(AVLNode<Key, Value>* parent);
     void removeFix(AVLNode<Key, Value>* n, int diff);
+    int fixBalances(AVLNode<Key, Value>* n);
+    int subtreeHeight(AVLNode<Key, Value>* n) const;
+
+    // erase() helpers: split and join detached subtrees of known height
+    std::size_t eraseRange(const Key* first, const Key* last);
+    void split(AVLNode<Key, Value>* n, int nHeight, const Key& key,
+               AVLNode<Key, Value>*& less, int& lessHeight,
+               AVLNode<Key, Value>*& rest, int& restHeight);
+    AVLNode<Key, Value>* join(AVLNode<Key, Value>* left, int leftHeight, AVLNode<Key, Value>* mid,
+                              AVLNode<Key, Value>* right, int rightHeight, int& height);
+    bool growFix(AVLNode<Key, Value>* p, int diff);
+    bool rebalanceNode(AVLNode<Key, Value>* n);
+    AVLNode<Key, Value>* detachSmallest(AVLNode<Key, Value>*& sub, int& subHeight);
 
 };
 
+template<class Key, class Value>
+AVLTree<Key, Value>::AVLTree() :
+    BinarySearchTree<Key, Value>()
+{
+
+}
+
+
+/*
+ * Copies other node for node, balances included (see assign()). Only
+ * once this constructor runs does cloneNode() make AVLNodes, so it
+ * cannot leave the copy to the base class copy constructor.
+ */
+template<class Key, class Value>
+AVLTree<Key, Value>::AVLTree(const AVLTree<Key, Value>& other) :
+    BinarySearchTree<Key, Value>()
+{
+    this->assign(other);
+}
+
+
 /*
- * Recall: If key is already in the tree, you should 
- * overwrite the current value with the updated value.
+ * insert(), upsert() and operator[] (see BinarySearchTree::findOrInsert):
+ * key's node, or a new node linked in and rebalanced.
+ * Recall: If key is already in the tree, insert() overwrites the current
+ * value with the updated value (then calls valueChanged()).
  */
 template<class Key, class Value>
-void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
+Node<Key, Value>* AVLTree<Key, Value>::findOrInsert(const Key& key, const Value& value,
+                                                    Node<Key, Value>* detached, bool& inserted)
 {
-    // TODO
+    Node<Key, Value>* leaf;
+    Node<Key, Value>* found = this->locate(key, leaf);
+    inserted = (found == NULL);
+    if (!inserted) return found;
+
+    AVLNode<Key, Value>* parent = static_cast<AVLNode<Key, Value>*>(leaf);
+    // create (or adopt) and insert new node
+    AVLNode<Key, Value>* mynode = static_cast<AVLNode<Key, Value>*>(this->makeNode(key, value, parent, detached));
+    ++this->size_;
     // if tree is empty, insert
-    if (this->empty()){
-        AVLNode<Key, Value>* mynode = new AVLNode<Key, Value>(new_item.first, new_item.second, nullptr);
+    if (!parent){
         this->root_ = mynode;
-        mynode->setBalance(0);
-    }
-    // if the value alread in key
-    else if (this->internalFind(new_item.first)){
-        this->internalFind(new_item.first)->setValue(new_item.second);
+        this->noteAttached(mynode);
     }
-    else {
-        AVLNode<Key, Value>* temp = static_cast<AVLNode<Key, Value>*>(this->root_);
-        AVLNode<Key, Value>* parent = getLeaf(new_item.first, temp);
-        // create and insert new node
-        AVLNode<Key, Value>* mynode = new AVLNode<Key, Value>(new_item.first, new_item.second, parent);
-        if (mynode->getKey() < parent->getKey()){
-            parent->setLeft(mynode);
-						parent->updateBalance(-1);
-						// if parent's previous balance was 0
-						if (parent->getBalance() + 1 == 0){
-							insertFix(parent, mynode);
-						}
+    else if (mynode->getKey() < parent->getKey()){
+        parent->setLeft(mynode);
+        this->noteAttached(mynode);
+        pathChanged(parent);
+        parent->updateBalance(-1);
+        // if parent's previous balance was 0
+        if (parent->getBalance() + 1 == 0){
+            BST_STAT(this->stats_.fixDepth = 0);
+            insertFix(parent, mynode);
         }
-        else{
-            parent->setRight(mynode);
-						parent->updateBalance(1);
-						// if parent's previous balance was 0
-						if (parent->getBalance() - 1 == 0){
-							insertFix(parent, mynode);
-						}
+    }
+    else{
+        parent->setRight(mynode);
+        this->noteAttached(mynode);
+        pathChanged(parent);
+        parent->updateBalance(1);
+        // if parent's previous balance was 0
+        if (parent->getBalance() - 1 == 0){
+            BST_STAT(this->stats_.fixDepth = 0);
+            insertFix(parent, mynode);
         }
     }
+    return mynode;
 }
 
 
 /*
- * insert() helper function
- * returns leaf node
- * Note: returned node will be the parent of the inserted node
- * Note 2: p = parent
+ * A value changed in place: its node's subtree data is stale
  */
 template<class Key, class Value>
-AVLNode<Key, Value>* AVLTree<Key, Value>::getLeaf(const Key& key, AVLNode<Key, Value>* p)
+void AVLTree<Key, Value>::valueChanged(Node<Key, Value>* n)
 {
-    // traverse to left child
-    if (key < p->getKey()){
-        // base case:
-        if (!p->getLeft()){
-            return p;
-        }
-        return getLeaf(key, p->getLeft());
-    }
-    // traverse to right child
-    else {
-        // base case:
-        if (!p->getRight()){
-            return p;
-        }
-        return getLeaf(key, p->getRight());
-    }
+    pathChanged(static_cast<AVLNode<Key, Value>*>(n));
 }
 
 
@@ -223,6 +270,9 @@ AVLNode<Key, Value>* AVLTree<Key, Value>::getLeaf(const Key& key, AVLNode<Key, V
 template<class Key, class Value>
 void AVLTree<Key, Value>::insertFix(AVLNode<Key, Value>* p, AVLNode<Key, Value>* n)
 {
+    BST_STAT(++this->stats_.insertFixCalls);
+    BST_STAT(this->stats_.maxInsertFixDepth =
+        std::max(this->stats_.maxInsertFixDepth, ++this->stats_.fixDepth));
     // if p is null or p's parent is null
     if (!p || !p->getParent()) return;
 		// g = p's parent
@@ -339,16 +389,20 @@ void AVLTree<Key, Value>::insertFix(AVLNode<Key, Value>* p, AVLNode<Key, Value>*
 template<class Key, class Value>
 void AVLTree<Key, Value>::rotateRight(AVLNode< Key, Value>* parent)
 {
+    BST_STAT(++this->stats_.rotateRights);
     AVLNode<Key, Value>* child = parent->getLeft();
 		AVLNode<Key, Value>* c = child->getRight();
 
-		// checking if grandparent exists or if parent is root_
-		if (this->root_ == parent){
+		// checking if grandparent exists; parent may also be the root of a
+		// subtree detached by erase(), which must not touch root_
+		AVLNode<Key, Value>* grandparent = parent->getParent();
+		if (!grandparent){
 			child->setParent(nullptr);
-			this->root_ = child;
+			if (this->root_ == parent){
+				this->root_ = child;
+			}
 		}
 		else {
-			AVLNode<Key, Value>* grandparent = parent->getParent();
 			child->setParent(grandparent);
 			if (grandparent->getLeft() == parent){
 				grandparent->setLeft(child);
@@ -366,6 +420,7 @@ void AVLTree<Key, Value>::rotateRight(AVLNode< Key, Value>* parent)
         
 		child->setRight(parent);
 		parent->setParent(child);
+		rotated(parent, child);
 
 }
 
@@ -376,16 +431,20 @@ void AVLTree<Key, Value>::rotateRight(AVLNode< Key, Value>* parent)
 template<class Key, class Value>
 void AVLTree<Key, Value>::rotateLeft(AVLNode<Key, Value>* parent)
 {
+    BST_STAT(++this->stats_.rotateLefts);
     AVLNode<Key, Value>* child = parent->getRight();
 		AVLNode<Key, Value>* c = child->getLeft();
 
-		// checking if grandparent exists or if parent is root_
-		if (this->root_ == parent){
+		// checking if grandparent exists; parent may also be the root of a
+		// subtree detached by erase(), which must not touch root_
+		AVLNode<Key, Value>* grandparent = parent->getParent();
+		if (!grandparent){
 			child->setParent(nullptr);
-			this->root_ = child;
+			if (this->root_ == parent){
+				this->root_ = child;
+			}
 		}
 		else {
-			AVLNode<Key, Value>* grandparent = parent->getParent();
 			child->setParent(grandparent);
 			if (grandparent->getLeft() == parent){
 				grandparent->setLeft(child);
@@ -403,24 +462,24 @@ void AVLTree<Key, Value>::rotateLeft(AVLNode<Key, Value>* parent)
 
 		child->setLeft(parent);
 		parent->setParent(child);
+		rotated(parent, child);
 
 }
 
 
 /*
+ * remove() (see BinarySearchTree::remove), pop_min()/pop_max() and
+ * extract() once they have the node: unlinks it and rebalances, the
+ * caller frees it.
  * Recall: The writeup specifies that if a node has 2 children you
  * should swap with the predecessor and then remove.
  */
 template<class Key, class Value>
-void AVLTree<Key, Value>::remove(const Key& key)
+void AVLTree<Key, Value>::detachNode(Node<Key, Value>* target)
 {
-    // TODO
-    // base case: empty tree
-    if (this->empty()) return;
-    
-    AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(this->internalFind(key));
-		if (!n) return;
-    
+    AVLNode<Key, Value>* n = static_cast<AVLNode<Key, Value>*>(target);
+    this->noteDetaching(n);
+
     // check if taget has 2 nodes
     if (n->getLeft() && n->getRight()){
         AVLNode<Key, Value>* pred = static_cast<AVLNode<Key, Value>*>(this->predecessor(n));
@@ -434,9 +493,19 @@ void AVLTree<Key, Value>::remove(const Key& key)
 				
     }
 
+    --this->size_;
+    BST_STAT(this->stats_.fixDepth = 0);
     AVLNode<Key, Value>* p = n->getParent();
+    // n is the root with at most one child: promote the child, no fix needed
+    if (!p){
+        AVLNode<Key, Value>* child = n->getLeft() ? n->getLeft() : n->getRight();
+        if (child){
+            child->setParent(nullptr);
+        }
+        this->root_ = child;
+    }
     // if p exists
-    if (p){
+    else {
       if (p->getLeft() == n){
 				// handling n's children, updating pointers
 				if (n->getLeft()){
@@ -451,7 +520,7 @@ void AVLTree<Key, Value>::remove(const Key& key)
 					p->setLeft(nullptr);
 				}
 
-        delete n;
+        pathChanged(p);
         removeFix(p, 1);
       }
 			else if (p->getRight() == n){
@@ -468,7 +537,7 @@ void AVLTree<Key, Value>::remove(const Key& key)
 					p->setRight(nullptr);
 				}
 
-				delete n;
+				pathChanged(p);
 				removeFix(p, -1);
       }
     }
@@ -483,6 +552,9 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* n, int diff)
 {
     // base case
     if (!n) return;
+    BST_STAT(++this->stats_.removeFixCalls);
+    BST_STAT(this->stats_.maxRemoveFixDepth =
+        std::max(this->stats_.maxRemoveFixDepth, ++this->stats_.fixDepth));
 		AVLNode<Key, Value>* p = n->getParent();
 		
     // calculations for next recursive call
@@ -609,6 +681,458 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* n, int diff)
 }
 
 
+/*
+ * Returns the number of levels in the tree in O(log n): the balances
+ * say which child is taller, so only one path needs to be followed
+ */
+template<class Key, class Value>
+int AVLTree<Key, Value>::height() const
+{
+    return subtreeHeight(static_cast<AVLNode<Key, Value>*>(this->root_));
+}
+
+
+/*
+ * height() helper function, for any subtree
+ */
+template<class Key, class Value>
+int AVLTree<Key, Value>::subtreeHeight(AVLNode<Key, Value>* n) const
+{
+    int levels = 0;
+    while (n){
+        ++levels;
+        // a balance of 0 means both children are equally tall
+        n = (n->getBalance() < 0) ? n->getLeft() : n->getRight();
+    }
+    return levels;
+}
+
+
+/*
+ * Removes every key k with first <= k < last and returns how many were
+ * removed. Instead of one remove() per key, the tree is split at first and
+ * at last, the middle part is freed in one pass and the two outer parts are
+ * joined again: O(log n + k) for k removed keys.
+ */
+template<class Key, class Value>
+std::size_t AVLTree<Key, Value>::erase(const Key& first, const Key& last)
+{
+    return eraseRange(&first, &last);
+}
+
+
+/*
+ * Removes the items in [first, last) and returns last, which stays valid.
+ * last may be end() to remove everything from first on.
+ */
+template<class Key, class Value>
+typename AVLTree<Key, Value>::iterator AVLTree<Key, Value>::erase(iterator first, iterator last)
+{
+    if (first == this->end()) return last;
+    // copied, the nodes holding them are about to be freed
+    Key from = first->first;
+    if (last == this->end()){
+        eraseRange(&from, NULL);
+    }
+    else {
+        Key to = last->first;
+        eraseRange(&from, &to);
+    }
+    return last;
+}
+
+
+/*
+ * erase() helper function
+ * removes the keys in [*first, *last); a NULL bound is open-ended
+ */
+template<class Key, class Value>
+std::size_t AVLTree<Key, Value>::eraseRange(const Key* first, const Key* last)
+{
+    if (this->empty()) return 0;
+    if (first && last && !(*first < *last)) return 0;
+
+    // from here on the tree is a set of detached subtrees
+    AVLNode<Key, Value>* all = static_cast<AVLNode<Key, Value>*>(this->root_);
+    int allHeight = height();
+    this->root_ = nullptr;
+
+    // all = less | middle | greater
+    AVLNode<Key, Value>* less = nullptr;
+    AVLNode<Key, Value>* middle = all;
+    AVLNode<Key, Value>* greater = nullptr;
+    int lessHeight = 0, middleHeight = allHeight, greaterHeight = 0;
+    if (first){
+        split(all, allHeight, *first, less, lessHeight, middle, middleHeight);
+    }
+    if (last){
+        AVLNode<Key, Value>* rest = middle;
+        split(rest, middleHeight, *last, middle, middleHeight, greater, greaterHeight);
+    }
+
+    std::size_t removed = this->deleteSubtree(middle);
+    this->size_ -= removed;
+
+    // joining needs a node between the two parts: borrow greater's smallest
+    if (!greater){
+        this->root_ = less;
+    }
+    else if (!less){
+        this->root_ = greater;
+    }
+    else {
+        AVLNode<Key, Value>* mid = detachSmallest(greater, greaterHeight);
+        int joinedHeight;
+        this->root_ = join(less, lessHeight, mid, greater, greaterHeight, joinedHeight);
+    }
+    this->resetEnds();
+    return removed;
+}
+
+
+/*
+ * erase() helper function
+ * splits the detached subtree n (nHeight levels) into the keys less than
+ * key and the rest, both valid AVL trees. Each level joins the part it
+ * cut off back on, and those joins add up to O(log n).
+ */
+template<class Key, class Value>
+void AVLTree<Key, Value>::split(AVLNode<Key, Value>* n, int nHeight, const Key& key,
+                                AVLNode<Key, Value>*& less, int& lessHeight,
+                                AVLNode<Key, Value>*& rest, int& restHeight)
+{
+    if (!n){
+        less = rest = nullptr;
+        lessHeight = restHeight = 0;
+        return;
+    }
+    BST_STAT((++this->stats_.nodesVisited, ++this->stats_.comparisons));
+    AVLNode<Key, Value>* left = n->getLeft();
+    AVLNode<Key, Value>* right = n->getRight();
+    int leftHeight = nHeight - 1 - (n->getBalance() > 0 ? 1 : 0);
+    int rightHeight = nHeight - 1 - (n->getBalance() < 0 ? 1 : 0);
+    if (left) left->setParent(nullptr);
+    if (right) right->setParent(nullptr);
+
+    if (n->getKey() < key){
+        // n and its left subtree are all less than key
+        AVLNode<Key, Value>* lessRight;
+        int lessRightHeight;
+        split(right, rightHeight, key, lessRight, lessRightHeight, rest, restHeight);
+        less = join(left, leftHeight, n, lessRight, lessRightHeight, lessHeight);
+    }
+    else {
+        AVLNode<Key, Value>* restLeft;
+        int restLeftHeight;
+        split(left, leftHeight, key, less, lessHeight, restLeft, restLeftHeight);
+        rest = join(restLeft, restLeftHeight, n, right, rightHeight, restHeight);
+    }
+}
+
+
+/*
+ * erase() helper function
+ * joins two detached subtrees and mid, whose key lies between them, into
+ * one AVL tree and returns its root. mid hangs where the shorter side
+ * meets the taller side's outer spine, so this costs
+ * O(|leftHeight - rightHeight| + 1).
+ */
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::join(AVLNode<Key, Value>* left, int leftHeight, AVLNode<Key, Value>* mid,
+                                               AVLNode<Key, Value>* right, int rightHeight, int& height)
+{
+    mid->setParent(nullptr);
+    if (leftHeight > rightHeight + 1){
+        // walk down left's right spine to a subtree at most one level taller than right
+        AVLNode<Key, Value>* p = nullptr;
+        AVLNode<Key, Value>* t = left;
+        int tHeight = leftHeight;
+        while (tHeight > rightHeight + 1){
+            tHeight -= (t->getBalance() < 0) ? 2 : 1;
+            p = t;
+            t = t->getRight();
+        }
+        mid->setLeft(t);
+        if (t) t->setParent(mid);
+        mid->setRight(right);
+        if (right) right->setParent(mid);
+        mid->setBalance(static_cast<int8_t>(rightHeight - tHeight));
+        p->setRight(mid);
+        mid->setParent(p);
+        pathChanged(mid);
+        // p's right subtree grew by one level
+        bool grew = growFix(p, 1);
+        while (left->getParent()) left = left->getParent();
+        height = leftHeight + (grew ? 1 : 0);
+        return left;
+    }
+    else if (rightHeight > leftHeight + 1){
+        // mirror image: walk down right's left spine
+        AVLNode<Key, Value>* p = nullptr;
+        AVLNode<Key, Value>* t = right;
+        int tHeight = rightHeight;
+        while (tHeight > leftHeight + 1){
+            tHeight -= (t->getBalance() > 0) ? 2 : 1;
+            p = t;
+            t = t->getLeft();
+        }
+        mid->setRight(t);
+        if (t) t->setParent(mid);
+        mid->setLeft(left);
+        if (left) left->setParent(mid);
+        mid->setBalance(static_cast<int8_t>(tHeight - leftHeight));
+        p->setLeft(mid);
+        mid->setParent(p);
+        pathChanged(mid);
+        bool grew = growFix(p, -1);
+        while (right->getParent()) right = right->getParent();
+        height = rightHeight + (grew ? 1 : 0);
+        return right;
+    }
+    else {
+        mid->setLeft(left);
+        if (left) left->setParent(mid);
+        mid->setRight(right);
+        if (right) right->setParent(mid);
+        mid->setBalance(static_cast<int8_t>(rightHeight - leftHeight));
+        pathChanged(mid);
+        height = std::max(leftHeight, rightHeight) + 1;
+        return mid;
+    }
+}
+
+
+/*
+ * join() helper function
+ * one of p's subtrees grew by a level (diff -1: left, 1: right). Updates
+ * balances upwards, rotating where needed, and returns true if the whole
+ * detached tree grew.
+ */
+template<class Key, class Value>
+bool AVLTree<Key, Value>::growFix(AVLNode<Key, Value>* p, int diff)
+{
+    while (p){
+        p->updateBalance(static_cast<int8_t>(diff));
+        if (p->getBalance() == 0) return false;
+        AVLNode<Key, Value>* parent = p->getParent();
+        int parentDiff = (parent && parent->getLeft() == p) ? -1 : 1;
+        // after the rotation p's subtree is only still taller if the
+        // heavy child was balanced
+        if (std::abs(p->getBalance()) == 2 && !rebalanceNode(p)) return false;
+        p = parent;
+        diff = parentDiff;
+    }
+    return true;
+}
+
+
+/*
+ * Restores balance at n, whose balance is -2 or 2, with a single or double
+ * rotation. Unlike insertFix this also handles a heavy child with balance
+ * 0, which joins can produce. Returns true in that case: the rotated
+ * subtree is then exactly as tall as n's heavy child plus one.
+ */
+template<class Key, class Value>
+bool AVLTree<Key, Value>::rebalanceNode(AVLNode<Key, Value>* n)
+{
+    if (n->getBalance() == 2){
+        AVLNode<Key, Value>* c = n->getRight();
+        if (c->getBalance() == 0){
+            rotateLeft(n);
+            n->setBalance(1);
+            c->setBalance(-1);
+            return true;
+        }
+        if (c->getBalance() == 1){
+            rotateLeft(n);
+            n->setBalance(0);
+            c->setBalance(0);
+        }
+        else {
+            AVLNode<Key, Value>* g = c->getLeft();
+            rotateRight(c);
+            rotateLeft(n);
+            n->setBalance(g->getBalance() == 1 ? -1 : 0);
+            c->setBalance(g->getBalance() == -1 ? 1 : 0);
+            g->setBalance(0);
+        }
+    }
+    else {
+        AVLNode<Key, Value>* c = n->getLeft();
+        if (c->getBalance() == 0){
+            rotateRight(n);
+            n->setBalance(-1);
+            c->setBalance(1);
+            return true;
+        }
+        if (c->getBalance() == -1){
+            rotateRight(n);
+            n->setBalance(0);
+            c->setBalance(0);
+        }
+        else {
+            AVLNode<Key, Value>* g = c->getRight();
+            rotateLeft(c);
+            rotateRight(n);
+            n->setBalance(g->getBalance() == -1 ? 1 : 0);
+            c->setBalance(g->getBalance() == 1 ? -1 : 0);
+            g->setBalance(0);
+        }
+    }
+    return false;
+}
+
+
+/*
+ * erase() helper function
+ * removes the smallest node from the detached subtree sub and returns it
+ * unlinked; sub and subHeight are updated
+ */
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::detachSmallest(AVLNode<Key, Value>*& sub, int& subHeight)
+{
+    AVLNode<Key, Value>* n = sub;
+    while (n->getLeft()) n = n->getLeft();
+    AVLNode<Key, Value>* p = n->getParent();
+    AVLNode<Key, Value>* child = n->getRight();
+    if (child) child->setParent(p);
+    if (!p){
+        sub = child;
+    }
+    else {
+        p->setLeft(child);
+        pathChanged(p);
+        BST_STAT(this->stats_.fixDepth = 0);
+        removeFix(p, 1);
+        // a rotation at the top moves sub down by a level or two
+        while (sub->getParent()) sub = sub->getParent();
+    }
+    subHeight = subtreeHeight(sub);
+    n->setRight(nullptr);
+    n->setParent(nullptr);
+    return n;
+}
+
+
+
+/*
+ * Rebuilds the tree into a complete tree (see BinarySearchTree::rebalance)
+ * and recomputes every balance to match the new shape
+ */
+template<class Key, class Value>
+void AVLTree<Key, Value>::rebalance()
+{
+    BinarySearchTree<Key, Value>::rebalance();
+    fixBalances(static_cast<AVLNode<Key, Value>*>(this->root_));
+}
+
+
+/*
+ * rebalance() helper function
+ * sets balances bottom-up and returns the height of n's subtree
+ */
+template<class Key, class Value>
+int AVLTree<Key, Value>::fixBalances(AVLNode<Key, Value>* n)
+{
+    if (!n) return 0;
+    int left = fixBalances(n->getLeft());
+    int right = fixBalances(n->getRight());
+    n->setBalance(static_cast<int8_t>(right - left));
+    return std::max(left, right) + 1;
+}
+
+
+template<class Key, class Value>
+Node<Key, Value>* AVLTree<Key, Value>::createNode(const Key& key, const Value& value, Node<Key, Value>* parent) const
+{
+    BST_STAT(++this->stats_.allocations);
+    return new AVLNode<Key, Value>(key, value, static_cast<AVLNode<Key, Value>*>(parent));
+}
+
+
+template<class Key, class Value>
+std::size_t AVLTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(AVLNode<Key, Value>);
+}
+
+
+/*
+ * assign() hook: an AVLNode with n's item and balance
+ */
+template<class Key, class Value>
+Node<Key, Value>* AVLTree<Key, Value>::cloneNode(const Node<Key, Value>* n, Node<Key, Value>* parent) const
+{
+    AVLNode<Key, Value>* copy = new AVLNode<Key, Value>(n->getKey(), n->getValue(), static_cast<AVLNode<Key, Value>*>(parent));
+    copy->setBalance(static_cast<const AVLNode<Key, Value>*>(n)->getBalance());
+    return copy;
+}
+
+
+/*
+ * Node handle hook: an AVLNode, not a subclass of it
+ */
+template<class Key, class Value>
+bool AVLTree<Key, Value>::canAdopt(const Node<Key, Value>* n) const
+{
+    return typeid(*n) == typeid(AVLNode<Key, Value>);
+}
+
+
+/*
+ * Node handle hook: a detached AVLNode as a new leaf, balance 0
+ */
+template<class Key, class Value>
+Node<Key, Value>* AVLTree<Key, Value>::adoptNode(Node<Key, Value>* n, Node<Key, Value>* parent) const
+{
+    BinarySearchTree<Key, Value>::adoptNode(n, parent);
+    static_cast<AVLNode<Key, Value>*>(n)->setBalance(0);
+    return n;
+}
+
+
+/*
+ * assign() hook: only AVL trees have balances to copy
+ */
+template<class Key, class Value>
+bool AVLTree<Key, Value>::canCloneFrom(const BinarySearchTree<Key, Value>& other) const
+{
+    return dynamic_cast<const AVLTree<Key, Value>*>(&other) != nullptr;
+}
+
+
+/*
+ * validate() hook: the stored balance must equal the real height
+ * difference, and an AVL tree never lets it exceed one
+ */
+template<class Key, class Value>
+bool AVLTree<Key, Value>::checkNode(const Node<Key, Value>* n, int leftHeight, int rightHeight) const
+{
+    int balance = static_cast<const AVLNode<Key, Value>*>(n)->getBalance();
+    return balance == rightHeight - leftHeight && std::abs(balance) <= 1;
+}
+
+
+/*
+ * Augmentation hook, nothing to update in a plain AVLTree
+ */
+template<class Key, class Value>
+void AVLTree<Key, Value>::pathChanged(AVLNode<Key, Value>* n)
+{
+
+}
+
+
+/*
+ * Augmentation hook, nothing to update in a plain AVLTree
+ */
+template<class Key, class Value>
+void AVLTree<Key, Value>::rotated(AVLNode<Key, Value>* lower, AVLNode<Key, Value>* upper)
+{
+
+}
+
+
 template<class Key, class Value>
 void AVLTree<Key, Value>::nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2)
 {
@@ -0,0 +1,340 @@
+#ifndef AVLSET_H
+#define AVLSET_H
+
+#include <iostream>
+#include <cstddef>
+#include <utility>
+#include "avlbst.h"
+
+/**
+ * The Value of an AVLSet's nodes: nothing. Node<Key, SetValue> below
+ * stores no item pair, only the key.
+ */
+struct SetValue
+{
+    bool operator==(const SetValue&) const { return true; }
+    bool operator!=(const SetValue&) const { return false; }
+};
+
+// prints nothing: BinarySearchTree::print() shows a set's keys as "(key, )"
+inline std::ostream& operator<<(std::ostream& out, const SetValue&)
+{
+    return out;
+}
+
+/**
+* Node specialization for key-only trees. It has the links and getters of
+* Node but stores just the key, so a node costs no Value slot and none of
+* the padding a std::pair<const Key, char> needs (for int keys an AVL
+* node shrinks from 48 to 40 bytes, for 8 byte keys from 56 to 48).
+* getValue() returns a shared empty SetValue and setValue() does nothing.
+* There is no getItem(): trees over these nodes iterate keys (see
+* AVLSet::iterator).
+*/
+template <typename Key>
+class Node<Key, SetValue>
+{
+public:
+    Node(const Key& key, const SetValue&, Node<Key, SetValue>* parent) :
+        parent_(parent), left_(NULL), right_(NULL), key_(key)
+    {
+
+    }
+    virtual ~Node()
+    {
+
+    }
+
+    const Key& getKey() const { return key_; }
+    const SetValue& getValue() const { return value(); }
+    SetValue& getValue() { return value(); }
+
+    virtual Node<Key, SetValue>* getParent() const { return parent_; }
+    virtual Node<Key, SetValue>* getLeft() const { return left_; }
+    virtual Node<Key, SetValue>* getRight() const { return right_; }
+
+    void setParent(Node<Key, SetValue>* parent) { parent_ = parent; }
+    void setLeft(Node<Key, SetValue>* left) { left_ = left; }
+    void setRight(Node<Key, SetValue>* right) { right_ = right; }
+    void setValue(const SetValue&) { }
+
+protected:
+    static SetValue& value()
+    {
+        static SetValue empty;
+        return empty;
+    }
+
+    Node<Key, SetValue>* parent_;
+    Node<Key, SetValue>* left_;
+    Node<Key, SetValue>* right_;
+    // last, so a small key leaves tail padding for AVLNode's balance
+    const Key key_;
+};
+
+/**
+* An ordered set of keys: an AVLTree whose nodes store only the key.
+* insert, erase and find are the AVLTree algorithms; the map interface
+* (pairs, operator[]) is not offered. Iterators visit the keys in order and
+* dereference to const Key&.
+*/
+template <typename Key>
+class AVLSet : protected AVLTree<Key, SetValue>
+{
+public:
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Key& operator*() const;
+        const Key* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class AVLSet<Key>;
+        iterator(Node<Key, SetValue>* ptr);
+        Node<Key, SetValue>* current_;
+    };
+
+    // see BinarySearchTree::node_type; mapped() is an empty SetValue
+    typedef typename AVLTree<Key, SetValue>::node_type node_type;
+
+    AVLSet();
+
+    bool insert(const Key& key);
+    bool contains(const Key& key) const;
+    std::size_t erase(const Key& key);
+    std::size_t erase(const Key& first, const Key& last);
+    iterator erase(iterator pos);
+
+    node_type extract(const Key& key);
+    node_type extract(iterator pos);
+    bool insert(node_type&& handle);
+    void merge(AVLSet<Key>& other);
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator min() const;
+    iterator max() const;
+
+    using AVLTree<Key, SetValue>::pop_min;
+    using AVLTree<Key, SetValue>::pop_max;
+    using AVLTree<Key, SetValue>::clear;
+    using AVLTree<Key, SetValue>::empty;
+    using AVLTree<Key, SetValue>::size;
+    using AVLTree<Key, SetValue>::height;
+    using AVLTree<Key, SetValue>::isBalanced;
+    using AVLTree<Key, SetValue>::validate;
+    using AVLTree<Key, SetValue>::print;
+    ShapeStats shape_stats() const;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the AVLSet::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::iterator::iterator() :
+    current_(NULL)
+{
+
+}
+
+template<class Key>
+AVLSet<Key>::iterator::iterator(Node<Key, SetValue>* ptr) :
+    current_(ptr)
+{
+
+}
+
+template<class Key>
+const Key& AVLSet<Key>::iterator::operator*() const
+{
+    return current_->getKey();
+}
+
+template<class Key>
+const Key* AVLSet<Key>::iterator::operator->() const
+{
+    return &(current_->getKey());
+}
+
+/**
+* Keys are unique, so the same key means the same node
+*/
+template<class Key>
+bool AVLSet<Key>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class Key>
+bool AVLSet<Key>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator& AVLSet<Key>::iterator::operator++()
+{
+    current_ = AVLSet<Key>::successor(current_);
+    return *this;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AVLSet::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::AVLSet() :
+    AVLTree<Key, SetValue>()
+{
+
+}
+
+/**
+* Adds key. Returns false if it was already in the set.
+*/
+template<class Key>
+bool AVLSet<Key>::insert(const Key& key)
+{
+    BST_STAT(++this->stats_.inserts);
+    bool inserted;
+    this->findOrInsert(key, SetValue(), NULL, inserted);
+    return inserted;
+}
+
+template<class Key>
+bool AVLSet<Key>::contains(const Key& key) const
+{
+    return this->internalFind(key) != NULL;
+}
+
+/**
+* Removes key. Returns the number of keys removed, 0 or 1.
+*/
+template<class Key>
+std::size_t AVLSet<Key>::erase(const Key& key)
+{
+    std::size_t before = this->size_;
+    AVLTree<Key, SetValue>::remove(key);
+    return before - this->size_;
+}
+
+/**
+* Removes every key in [first, last), see AVLTree::erase()
+*/
+template<class Key>
+std::size_t AVLSet<Key>::erase(const Key& first, const Key& last)
+{
+    return AVLTree<Key, SetValue>::erase(first, last);
+}
+
+/**
+* Removes the key at pos and returns the key after it, see
+* BinarySearchTree::erase(iterator)
+*/
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::erase(iterator pos)
+{
+    Node<Key, SetValue>* n = pos.current_;
+    if (n == NULL) return end();
+    BST_STAT(++this->stats_.removes);
+    Node<Key, SetValue>* next = AVLSet<Key>::successor(n);
+    this->removeNode(n);
+    return iterator(next);
+}
+
+/**
+* Unlinks key's node and hands it over, see BinarySearchTree::extract()
+*/
+template<class Key>
+typename AVLSet<Key>::node_type AVLSet<Key>::extract(const Key& key)
+{
+    return AVLTree<Key, SetValue>::extract(key);
+}
+
+template<class Key>
+typename AVLSet<Key>::node_type AVLSet<Key>::extract(iterator pos)
+{
+    return AVLTree<Key, SetValue>::extract(this->iteratorAt(pos.current_));
+}
+
+/**
+* Links the handle's node in without allocating. Returns false, and the
+* handle keeps its node, if the key was already in the set.
+*/
+template<class Key>
+bool AVLSet<Key>::insert(node_type&& handle)
+{
+    return AVLTree<Key, SetValue>::insert(std::move(handle)).second;
+}
+
+/**
+* Moves the nodes of the keys this set lacks over from other, see
+* BinarySearchTree::merge()
+*/
+template<class Key>
+void AVLSet<Key>::merge(AVLSet<Key>& other)
+{
+    AVLTree<Key, SetValue>::merge(other);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::begin() const
+{
+    return iterator(this->getSmallestNode());
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::end() const
+{
+    return iterator(NULL);
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::find(const Key& key) const
+{
+    return iterator(this->internalFind(key));
+}
+
+/**
+* The smallest key, end() if the set is empty. O(1)
+*/
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::min() const
+{
+    return iterator(this->min_);
+}
+
+/**
+* The largest key, end() if the set is empty. O(1)
+*/
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::max() const
+{
+    return iterator(this->max_);
+}
+
+/**
+* BinarySearchTree::shape_stats(), with the key as the item
+*/
+template<class Key>
+ShapeStats AVLSet<Key>::shape_stats() const
+{
+    ShapeStats shape = AVLTree<Key, SetValue>::shape_stats();
+    shape.itemBytes = sizeof(Key);
+    return shape;
+}
+
+#endif
@@ -0,0 +1,223 @@
+// Per-operation latency benchmark: BinarySearchTree vs AVLTree vs
+// ScapegoatTree vs std::map.
+//
+// usage: bench-latency [--format csv|json] [--sizes N,N,...] [--max-size N]
+//                      [--trees bst,avl,scapegoat,map]
+//                      [--workloads sequential,reverse,random,zipfian]
+//                      [--bst-limit N] [--seed N]
+//
+// Where bench reports average throughput, this times every single insert,
+// find and remove with CycleClock and records it in a LatencyHistogram, then
+// reports the mean, p50, p99, p99.9 and max per tree, workload, size and
+// operation, in nanoseconds. clear() is timed once per run, after the tree
+// has been refilled. Each sample includes one CycleClock read (a few ns).
+// Sizes default to 10^3 .. 10^6; --max-size extends the decades up to 10^8.
+// Sorted keys above --bst-limit (default 20000) are skipped for the
+// unbalanced BinarySearchTree, as in bench.
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "bst.h"
+#include "avlbst.h"
+#include "scapegoat.h"
+#include "bench.h"
+
+using namespace std;
+
+// keeps the optimizer from discarding lookups
+volatile uint64_t benchSink = 0;
+
+/**
+ * Prints one row (or JSON object) per histogram, with tick counts
+ * converted to nanoseconds.
+ */
+class LatencyWriter
+{
+public:
+    LatencyWriter(ostream& out, bool json) : out_(out), json_(json), rows_(0), nsPerTick_(CycleClock::nsPerTick()) { }
+
+    void begin()
+    {
+        if (json_) out_ << "[\n";
+        else out_ << "tree,workload,size,op,count,mean_ns,p50_ns,p99_ns,p999_ns,max_ns,status\n";
+    }
+
+    void add(const string& tree, Workload workload, uint64_t size, const string& op,
+             const LatencyHistogram& histogram, const string& status)
+    {
+        double mean = histogram.mean() * nsPerTick_;
+        double p50 = histogram.percentile(0.50) * nsPerTick_;
+        double p99 = histogram.percentile(0.99) * nsPerTick_;
+        double p999 = histogram.percentile(0.999) * nsPerTick_;
+        double max = histogram.max() * nsPerTick_;
+        if (json_){
+            out_ << (rows_ ? ",\n" : "") << "  {\"tree\": \"" << tree
+                 << "\", \"workload\": \"" << workloadName(workload)
+                 << "\", \"size\": " << size
+                 << ", \"op\": \"" << op
+                 << "\", \"count\": " << histogram.count()
+                 << ", \"mean_ns\": " << mean
+                 << ", \"p50_ns\": " << p50
+                 << ", \"p99_ns\": " << p99
+                 << ", \"p999_ns\": " << p999
+                 << ", \"max_ns\": " << max
+                 << ", \"status\": \"" << status << "\"}";
+        }
+        else {
+            out_ << tree << ',' << workloadName(workload) << ',' << size << ',' << op << ','
+                 << histogram.count() << ',' << mean << ',' << p50 << ',' << p99 << ','
+                 << p999 << ',' << max << ',' << status << '\n';
+        }
+        out_.flush();
+        ++rows_;
+    }
+
+    void end()
+    {
+        if (json_) out_ << (rows_ ? "\n" : "") << "]\n";
+        out_.flush();
+    }
+
+private:
+    ostream& out_;
+    bool json_;
+    uint64_t rows_;
+    double nsPerTick_;
+};
+
+/*
+ * Times every insert, find and remove, then one clear(), for one tree,
+ * workload and size.
+ */
+template<class Tree>
+void runLatency(const string& treeName, Workload workload, const vector<uint64_t>& keys,
+                LatencyWriter& writer)
+{
+    LatencyHistogram insertLatency, findLatency, removeLatency, clearLatency;
+    Tree tree;
+    for (size_t i = 0; i < keys.size(); ++i){
+        uint64_t start = CycleClock::now();
+        benchInsert(tree, keys[i]);
+        insertLatency.record(CycleClock::now() - start);
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < keys.size(); ++i){
+        uint64_t start = CycleClock::now();
+        sum += benchFind(tree, keys[i]);
+        findLatency.record(CycleClock::now() - start);
+    }
+    benchSink = benchSink + sum;
+    for (size_t i = 0; i < keys.size(); ++i){
+        uint64_t start = CycleClock::now();
+        benchRemove(tree, keys[i]);
+        removeLatency.record(CycleClock::now() - start);
+    }
+    for (size_t i = 0; i < keys.size(); ++i) benchInsert(tree, keys[i]);
+    uint64_t start = CycleClock::now();
+    tree.clear();
+    clearLatency.record(CycleClock::now() - start);
+
+    writer.add(treeName, workload, keys.size(), "insert", insertLatency, "ok");
+    writer.add(treeName, workload, keys.size(), "find", findLatency, "ok");
+    writer.add(treeName, workload, keys.size(), "remove", removeLatency, "ok");
+    writer.add(treeName, workload, keys.size(), "clear", clearLatency, "ok");
+}
+
+void skipLatency(const string& treeName, Workload workload, uint64_t size, LatencyWriter& writer)
+{
+    const char* ops[] = { "insert", "find", "remove", "clear" };
+    LatencyHistogram none;
+    for (int i = 0; i < 4; ++i){
+        writer.add(treeName, workload, size, ops[i], none, "skipped-degenerate");
+    }
+}
+
+void usage()
+{
+    cerr << "usage: bench-latency [--format csv|json] [--sizes N,N,...] [--max-size N]" << endl
+         << "                     [--trees bst,avl,scapegoat,map]" << endl
+         << "                     [--workloads sequential,reverse,random,zipfian]" << endl
+         << "                     [--bst-limit N] [--seed N]" << endl;
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    vector<uint64_t> sizes;
+    uint64_t maxSize = 1000000;
+    uint64_t bstLimit = 20000;
+    uint64_t seed = 104;
+    vector<string> trees = splitList("bst,avl,scapegoat,map");
+    vector<string> workloadNames = splitList("sequential,reverse,random,zipfian");
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (i + 1 >= argc) usage();
+        string value = argv[++i];
+        if (arg == "--format"){
+            if (value != "csv" && value != "json") usage();
+            json = (value == "json");
+        }
+        else if (arg == "--sizes"){
+            vector<string> items = splitList(value);
+            for (size_t j = 0; j < items.size(); ++j) sizes.push_back(strtoull(items[j].c_str(), NULL, 10));
+        }
+        else if (arg == "--max-size") maxSize = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--trees") trees = splitList(value);
+        else if (arg == "--workloads") workloadNames = splitList(value);
+        else if (arg == "--bst-limit") bstLimit = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else usage();
+    }
+    if (sizes.empty()){
+        for (uint64_t n = 1000; n <= maxSize && n <= 100000000; n *= 10) sizes.push_back(n);
+    }
+
+    vector<Workload> workloads;
+    for (size_t i = 0; i < workloadNames.size(); ++i){
+        const string& name = workloadNames[i];
+        if (name == "sequential") workloads.push_back(SEQUENTIAL);
+        else if (name == "reverse") workloads.push_back(REVERSE);
+        else if (name == "random") workloads.push_back(RANDOM);
+        else if (name == "zipfian") workloads.push_back(ZIPFIAN);
+        else usage();
+    }
+
+    LatencyWriter writer(cout, json);
+    writer.begin();
+    for (size_t s = 0; s < sizes.size(); ++s){
+        for (size_t w = 0; w < workloads.size(); ++w){
+            vector<uint64_t> keys = workloadKeys(workloads[w], sizes[s], seed);
+            for (size_t t = 0; t < trees.size(); ++t){
+                if (trees[t] == "bst"){
+                    bool sorted = (workloads[w] == SEQUENTIAL || workloads[w] == REVERSE);
+                    if (sorted && sizes[s] > bstLimit){
+                        skipLatency("bst", workloads[w], sizes[s], writer);
+                    }
+                    else {
+                        runLatency<BinarySearchTree<uint64_t, uint64_t> >("bst", workloads[w], keys, writer);
+                    }
+                }
+                else if (trees[t] == "avl"){
+                    runLatency<AVLTree<uint64_t, uint64_t> >("avl", workloads[w], keys, writer);
+                }
+                else if (trees[t] == "scapegoat"){
+                    runLatency<ScapegoatTree<uint64_t, uint64_t> >("scapegoat", workloads[w], keys, writer);
+                }
+                else if (trees[t] == "map"){
+                    runLatency<map<uint64_t, uint64_t> >("map", workloads[w], keys, writer);
+                }
+                else {
+                    usage();
+                }
+            }
+        }
+    }
+    writer.end();
+    return 0;
+}
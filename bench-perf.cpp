@@ -0,0 +1,380 @@
+// Hardware counter benchmark: BinarySearchTree vs AVLTree vs ScapegoatTree
+// vs std::map.
+//
+// usage: bench-perf [--format csv|json] [--sizes N,N,...] [--max-size N]
+//                   [--trees bst,avl,scapegoat,map]
+//                   [--workloads sequential,reverse,random,zipfian]
+//                   [--bst-limit N] [--seed N]
+//
+// For every tree, workload and size it runs insert, find and a full
+// iteration, reading perf_event_open counters through the libperf library
+// shipped in hw4_tests.tar.gz around each phase, and reports per operation
+// wall time, task clock, cycles, instructions, IPC, cache misses and branch
+// mispredictions.
+// Counters the kernel or CPU does not provide (containers, VMs without a
+// virtual PMU, perf_event_paranoid) are reported empty in CSV and null in
+// JSON, and the row's status says which ones were missing; wall time is
+// always reported.
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <libperf.h>
+#include "bst.h"
+#include "avlbst.h"
+#include "scapegoat.h"
+#include "bench.h"
+
+using namespace std;
+
+// keeps the optimizer from discarding lookups and scans
+volatile uint64_t benchSink = 0;
+
+/**
+ * A counter the benchmark reports, with the perf_event_attr libperf uses
+ * for it so availability can be probed before handing it to libperf.
+ */
+struct PerfEvent
+{
+    const char* name;
+    int libperfCounter;
+    uint32_t type;
+    uint64_t config;
+};
+
+const PerfEvent PERF_EVENTS[] = {
+    { "task_clock_ns", LIBPERF_COUNT_SW_TASK_CLOCK, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { "cycles", LIBPERF_COUNT_HW_CPU_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", LIBPERF_COUNT_HW_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache_misses", LIBPERF_COUNT_HW_CACHE_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "branch_misses", LIBPERF_COUNT_HW_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+};
+const int PERF_EVENT_COUNT = sizeof(PERF_EVENTS) / sizeof(PERF_EVENTS[0]);
+const int CYCLES = 1;
+const int INSTRUCTIONS = 2;
+
+/**
+ * The PERF_EVENTS counters for this thread, read through libperf.
+ * libperf asserts when it cannot open a counter it is asked to enable or
+ * read, so each event is first probed with a plain perf_event_open() and
+ * only the ones that open are used.
+ */
+class PerfCounters
+{
+public:
+    PerfCounters() : libperf_(NULL), anyAvailable_(false)
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            available_[i] = probe(PERF_EVENTS[i]);
+            anyAvailable_ = anyAvailable_ || available_[i];
+        }
+        if (!anyAvailable_) return;
+
+        libperf_ = libperf_initialize(-1, -1);
+        // libperf opens a log file named after the thread id in the current
+        // directory; nothing is logged unless libperf_finalize() is called
+        std::string log = std::to_string(static_cast<long>(syscall(SYS_gettid)));
+        unlink(log.c_str());
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            if (available_[i]) libperf_enablecounter(libperf_, PERF_EVENTS[i].libperfCounter);
+        }
+    }
+
+    ~PerfCounters()
+    {
+        if (libperf_ == NULL) return;
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            if (available_[i]) libperf_disablecounter(libperf_, PERF_EVENTS[i].libperfCounter);
+        }
+        libperf_close(libperf_);
+    }
+
+    bool available(int event) const { return available_[event]; }
+
+    // Reads every available counter into values, unavailable ones read 0.
+    void read(uint64_t values[PERF_EVENT_COUNT]) const
+    {
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            values[i] = available_[i] ? libperf_readcounter(libperf_, PERF_EVENTS[i].libperfCounter) : 0;
+        }
+    }
+
+    // Names of the counters that could not be opened, ";" separated so
+    // the list fits in one CSV field.
+    std::string missing() const
+    {
+        std::string names;
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            if (!available_[i]) names += (names.empty() ? "" : ";") + std::string(PERF_EVENTS[i].name);
+        }
+        return names;
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+private:
+    static bool probe(const PerfEvent& event)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.inherit = 1;
+        attr.disabled = 1;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) return false;
+        close(fd);
+        return true;
+    }
+
+    struct libperf_data* libperf_;
+    bool available_[PERF_EVENT_COUNT];
+    bool anyAvailable_;
+};
+
+/**
+ * Counter deltas for one phase of a run, divided by its operation count.
+ */
+class PerfSample
+{
+public:
+    explicit PerfSample(const PerfCounters& counters) : counters_(counters)
+    {
+        counters_.read(start_);
+    }
+
+    void stop()
+    {
+        counters_.read(stop_);
+        seconds_ = watch_.seconds();
+    }
+
+    double seconds() const { return seconds_; }
+    uint64_t delta(int event) const { return stop_[event] - start_[event]; }
+
+private:
+    const PerfCounters& counters_;
+    Stopwatch watch_;
+    uint64_t start_[PERF_EVENT_COUNT];
+    uint64_t stop_[PERF_EVENT_COUNT];
+    double seconds_;
+};
+
+/**
+ * Prints one row (or JSON object) per measured phase.
+ */
+class PerfWriter
+{
+public:
+    PerfWriter(ostream& out, bool json, const PerfCounters& counters) :
+        out_(out), json_(json), counters_(counters), rows_(0) { }
+
+    void begin()
+    {
+        if (json_){
+            out_ << "[\n";
+            return;
+        }
+        out_ << "tree,workload,size,op,ops,ns_per_op";
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i) out_ << ',' << PERF_EVENTS[i].name << "_per_op";
+        out_ << ",ipc,status\n";
+    }
+
+    void add(const string& tree, Workload workload, uint64_t size, const string& op,
+             uint64_t ops, const PerfSample* sample, const string& skipped)
+    {
+        string status = skipped;
+        if (status.empty()){
+            status = counters_.missing().empty() ? "ok" : "missing:" + counters_.missing();
+        }
+        if (json_){
+            out_ << (rows_ ? ",\n" : "") << "  {\"tree\": \"" << tree
+                 << "\", \"workload\": \"" << workloadName(workload)
+                 << "\", \"size\": " << size
+                 << ", \"op\": \"" << op
+                 << "\", \"ops\": " << ops
+                 << ", \"ns_per_op\": ";
+        }
+        else {
+            out_ << tree << ',' << workloadName(workload) << ',' << size << ',' << op << ',' << ops << ',';
+        }
+        field(sample != NULL && ops > 0, sample ? sample->seconds() * 1e9 / ops : 0);
+        for (int i = 0; i < PERF_EVENT_COUNT; ++i){
+            if (json_) out_ << ", \"" << PERF_EVENTS[i].name << "_per_op\": ";
+            else out_ << ',';
+            field(sample != NULL && ops > 0 && counters_.available(i),
+                  sample ? static_cast<double>(sample->delta(i)) / ops : 0);
+        }
+        if (json_) out_ << ", \"ipc\": ";
+        else out_ << ',';
+        bool haveIpc = sample != NULL && counters_.available(CYCLES) && counters_.available(INSTRUCTIONS) &&
+                       sample->delta(CYCLES) > 0;
+        field(haveIpc, haveIpc ? static_cast<double>(sample->delta(INSTRUCTIONS)) / sample->delta(CYCLES) : 0);
+        if (json_) out_ << ", \"status\": \"" << status << "\"}";
+        else out_ << ',' << status << '\n';
+        out_.flush();
+        ++rows_;
+    }
+
+    void end()
+    {
+        if (json_) out_ << (rows_ ? "\n" : "") << "]\n";
+        out_.flush();
+    }
+
+private:
+    // writes value, or an empty CSV field / JSON null when it is not known
+    void field(bool known, double value)
+    {
+        if (known) out_ << value;
+        else if (json_) out_ << "null";
+    }
+
+    ostream& out_;
+    bool json_;
+    const PerfCounters& counters_;
+    uint64_t rows_;
+};
+
+/*
+ * Measures insert, find and iterate for one tree, workload and size.
+ */
+template<class Tree>
+void runPerf(const string& treeName, Workload workload, const vector<uint64_t>& keys,
+             const PerfCounters& counters, PerfWriter& writer)
+{
+    Tree tree;
+    {
+        PerfSample sample(counters);
+        for (size_t i = 0; i < keys.size(); ++i) benchInsert(tree, keys[i]);
+        sample.stop();
+        writer.add(treeName, workload, keys.size(), "insert", keys.size(), &sample, "");
+    }
+    {
+        PerfSample sample(counters);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < keys.size(); ++i) sum += benchFind(tree, keys[i]);
+        sample.stop();
+        benchSink = benchSink + sum;
+        writer.add(treeName, workload, keys.size(), "find", keys.size(), &sample, "");
+    }
+    {
+        PerfSample sample(counters);
+        uint64_t sum = 0, count = 0;
+        for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it){
+            sum += it->second;
+            ++count;
+        }
+        sample.stop();
+        benchSink = benchSink + sum;
+        writer.add(treeName, workload, keys.size(), "iterate", count, &sample, "");
+    }
+}
+
+void skipPerf(const string& treeName, Workload workload, uint64_t size, PerfWriter& writer)
+{
+    const char* ops[] = { "insert", "find", "iterate" };
+    for (int i = 0; i < 3; ++i){
+        writer.add(treeName, workload, size, ops[i], 0, NULL, "skipped-degenerate");
+    }
+}
+
+void usage()
+{
+    cerr << "usage: bench-perf [--format csv|json] [--sizes N,N,...] [--max-size N]" << endl
+         << "                  [--trees bst,avl,scapegoat,map]" << endl
+         << "                  [--workloads sequential,reverse,random,zipfian]" << endl
+         << "                  [--bst-limit N] [--seed N]" << endl;
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    vector<uint64_t> sizes;
+    uint64_t maxSize = 1000000;
+    uint64_t bstLimit = 20000;
+    uint64_t seed = 104;
+    vector<string> trees = splitList("bst,avl,scapegoat,map");
+    vector<string> workloadNames = splitList("sequential,reverse,random,zipfian");
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (i + 1 >= argc) usage();
+        string value = argv[++i];
+        if (arg == "--format"){
+            if (value != "csv" && value != "json") usage();
+            json = (value == "json");
+        }
+        else if (arg == "--sizes"){
+            vector<string> items = splitList(value);
+            for (size_t j = 0; j < items.size(); ++j) sizes.push_back(strtoull(items[j].c_str(), NULL, 10));
+        }
+        else if (arg == "--max-size") maxSize = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--trees") trees = splitList(value);
+        else if (arg == "--workloads") workloadNames = splitList(value);
+        else if (arg == "--bst-limit") bstLimit = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else usage();
+    }
+    if (sizes.empty()){
+        for (uint64_t n = 1000; n <= maxSize && n <= 100000000; n *= 10) sizes.push_back(n);
+    }
+
+    vector<Workload> workloads;
+    for (size_t i = 0; i < workloadNames.size(); ++i){
+        const string& name = workloadNames[i];
+        if (name == "sequential") workloads.push_back(SEQUENTIAL);
+        else if (name == "reverse") workloads.push_back(REVERSE);
+        else if (name == "random") workloads.push_back(RANDOM);
+        else if (name == "zipfian") workloads.push_back(ZIPFIAN);
+        else usage();
+    }
+
+    PerfCounters counters;
+    if (!counters.missing().empty()){
+        cerr << "bench-perf: counters not available here: " << counters.missing() << endl;
+    }
+
+    PerfWriter writer(cout, json, counters);
+    writer.begin();
+    for (size_t s = 0; s < sizes.size(); ++s){
+        for (size_t w = 0; w < workloads.size(); ++w){
+            vector<uint64_t> keys = workloadKeys(workloads[w], sizes[s], seed);
+            for (size_t t = 0; t < trees.size(); ++t){
+                if (trees[t] == "bst"){
+                    bool sorted = (workloads[w] == SEQUENTIAL || workloads[w] == REVERSE);
+                    if (sorted && sizes[s] > bstLimit){
+                        skipPerf("bst", workloads[w], sizes[s], writer);
+                    }
+                    else {
+                        runPerf<BinarySearchTree<uint64_t, uint64_t> >("bst", workloads[w], keys, counters, writer);
+                    }
+                }
+                else if (trees[t] == "avl"){
+                    runPerf<AVLTree<uint64_t, uint64_t> >("avl", workloads[w], keys, counters, writer);
+                }
+                else if (trees[t] == "scapegoat"){
+                    runPerf<ScapegoatTree<uint64_t, uint64_t> >("scapegoat", workloads[w], keys, counters, writer);
+                }
+                else if (trees[t] == "map"){
+                    runPerf<map<uint64_t, uint64_t> >("map", workloads[w], keys, counters, writer);
+                }
+                else {
+                    usage();
+                }
+            }
+        }
+    }
+    writer.end();
+    return 0;
+}
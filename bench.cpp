@@ -0,0 +1,238 @@
+// Workload benchmark: BinarySearchTree vs AVLTree vs std::map.
+//
+// usage: bench [--format csv|json] [--sizes N,N,...] [--max-size N]
+//              [--trees bst,avl,map,avl-large,hotcold-large]
+//              [--workloads sequential,reverse,random,zipfian]
+//              [--bst-limit N] [--seed N]
+//
+// For every tree, workload and size it times inserting the workload's keys,
+// finding them again (one at a time, in find_batch() groups of 256, and in
+// sorted order with finger search from the previous hit), iterating over
+// the whole tree and removing them one by one, then refills the tree and
+// times erasing it in runs of 1024 consecutive keys. It writes one CSV row
+// (or JSON object) per operation to stdout.
+// Sizes default to 10^3 .. 10^6; --max-size extends the decades up to 10^8.
+// An unbalanced BinarySearchTree fed sorted keys degenerates into a list
+// (O(n^2) total, recursion n deep), so those runs above --bst-limit keys
+// (default 20000) are reported as skipped.
+// avl-large and hotcold-large (not run by default) store 256 byte values,
+// inline in an AVLTree and out of line in a HotColdAVLTree.
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "bst.h"
+#include "avlbst.h"
+#include "hotcold_tree.h"
+#include "bench.h"
+
+using namespace std;
+
+// keeps the optimizer from discarding lookups and scans
+volatile uint64_t benchSink = 0;
+
+// keys per find_batch() call in the find-batch operation
+const size_t FIND_BATCH_SIZE = 256;
+
+// consecutive keys per range in the erase-range operation
+const size_t ERASE_RANGE_SIZE = 1024;
+
+template<class Key, class Value>
+void benchEraseRange(AVLTree<Key, Value>& tree, const vector<uint64_t>& sorted, size_t first, size_t last)
+{
+    if (last < sorted.size()) tree.erase(sorted[first], sorted[last]);
+    else tree.erase(tree.find(sorted[first]), tree.end());
+}
+
+/*
+ * Runs insert, the finds, iterate, remove and erase-range for one tree,
+ * workload and size.
+ */
+template<class Tree>
+void runSuite(const string& treeName, Workload workload, const vector<uint64_t>& keys,
+              ResultWriter& writer)
+{
+    BenchResult result;
+    result.tree = treeName;
+    result.workload = workloadName(workload);
+    result.size = keys.size();
+    result.status = "ok";
+
+    Tree tree;
+    {
+        Stopwatch watch;
+        for (size_t i = 0; i < keys.size(); ++i) benchInsert(tree, keys[i]);
+        result.op = "insert";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        Stopwatch watch;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < keys.size(); ++i) sum += benchFind(tree, keys[i]);
+        benchSink = benchSink + sum;
+        result.op = "find";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        Stopwatch watch;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < keys.size(); i += FIND_BATCH_SIZE){
+            sum += benchFindBatch(tree, keys, i, std::min(keys.size(), i + FIND_BATCH_SIZE));
+        }
+        benchSink = benchSink + sum;
+        result.op = "find-batch";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        vector<uint64_t> sorted(keys);
+        sort(sorted.begin(), sorted.end());
+        Stopwatch watch;
+        benchSink = benchSink + benchFindFinger(tree, sorted);
+        result.op = "find-finger";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        Stopwatch watch;
+        uint64_t sum = 0, count = 0;
+        for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it){
+            sum += it->second;
+            ++count;
+        }
+        benchSink = benchSink + sum;
+        result.op = "iterate";
+        result.ops = count;
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        Stopwatch watch;
+        for (size_t i = 0; i < keys.size(); ++i) benchRemove(tree, keys[i]);
+        result.op = "remove";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+    {
+        for (size_t i = 0; i < keys.size(); ++i) benchInsert(tree, keys[i]);
+        vector<uint64_t> sorted(keys);
+        sort(sorted.begin(), sorted.end());
+        Stopwatch watch;
+        for (size_t i = 0; i < sorted.size(); i += ERASE_RANGE_SIZE){
+            benchEraseRange(tree, sorted, i, std::min(sorted.size(), i + ERASE_RANGE_SIZE));
+        }
+        result.op = "erase-range";
+        result.ops = keys.size();
+        result.seconds = watch.seconds();
+        writer.add(result);
+    }
+}
+
+void skipSuite(const string& treeName, Workload workload, uint64_t size, ResultWriter& writer)
+{
+    const char* ops[] = { "insert", "find", "find-batch", "find-finger", "iterate", "remove", "erase-range" };
+    for (int i = 0; i < 7; ++i){
+        BenchResult result = { treeName, workloadName(workload), size, ops[i], 0, 0, "skipped-degenerate" };
+        writer.add(result);
+    }
+}
+
+void usage()
+{
+    cerr << "usage: bench [--format csv|json] [--sizes N,N,...] [--max-size N]" << endl
+         << "             [--trees bst,avl,map,avl-large,hotcold-large]" << endl
+         << "             [--workloads sequential,reverse,random,zipfian]" << endl
+         << "             [--bst-limit N] [--seed N]" << endl;
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    vector<uint64_t> sizes;
+    uint64_t maxSize = 1000000;
+    uint64_t bstLimit = 20000;
+    uint64_t seed = 104;
+    vector<string> trees = splitList("bst,avl,map");
+    vector<string> workloadNames = splitList("sequential,reverse,random,zipfian");
+
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (i + 1 >= argc) usage();
+        string value = argv[++i];
+        if (arg == "--format"){
+            if (value != "csv" && value != "json") usage();
+            json = (value == "json");
+        }
+        else if (arg == "--sizes"){
+            vector<string> items = splitList(value);
+            for (size_t j = 0; j < items.size(); ++j) sizes.push_back(strtoull(items[j].c_str(), NULL, 10));
+        }
+        else if (arg == "--max-size") maxSize = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--trees") trees = splitList(value);
+        else if (arg == "--workloads") workloadNames = splitList(value);
+        else if (arg == "--bst-limit") bstLimit = strtoull(value.c_str(), NULL, 10);
+        else if (arg == "--seed") seed = strtoull(value.c_str(), NULL, 10);
+        else usage();
+    }
+    if (sizes.empty()){
+        for (uint64_t n = 1000; n <= maxSize && n <= 100000000; n *= 10) sizes.push_back(n);
+    }
+
+    vector<Workload> workloads;
+    for (size_t i = 0; i < workloadNames.size(); ++i){
+        const string& name = workloadNames[i];
+        if (name == "sequential") workloads.push_back(SEQUENTIAL);
+        else if (name == "reverse") workloads.push_back(REVERSE);
+        else if (name == "random") workloads.push_back(RANDOM);
+        else if (name == "zipfian") workloads.push_back(ZIPFIAN);
+        else usage();
+    }
+
+    ResultWriter writer(cout, json);
+    writer.begin();
+    for (size_t s = 0; s < sizes.size(); ++s){
+        for (size_t w = 0; w < workloads.size(); ++w){
+            vector<uint64_t> keys = workloadKeys(workloads[w], sizes[s], seed);
+            for (size_t t = 0; t < trees.size(); ++t){
+                if (trees[t] == "bst"){
+                    bool sorted = (workloads[w] == SEQUENTIAL || workloads[w] == REVERSE);
+                    if (sorted && sizes[s] > bstLimit){
+                        skipSuite("bst", workloads[w], sizes[s], writer);
+                    }
+                    else {
+                        runSuite<BinarySearchTree<uint64_t, uint64_t> >("bst", workloads[w], keys, writer);
+                    }
+                }
+                else if (trees[t] == "avl"){
+                    runSuite<AVLTree<uint64_t, uint64_t> >("avl", workloads[w], keys, writer);
+                }
+                else if (trees[t] == "avl-large"){
+                    runSuite<AVLTree<uint64_t, LargeValue> >("avl-large", workloads[w], keys, writer);
+                }
+                else if (trees[t] == "hotcold-large"){
+                    runSuite<HotColdAVLTree<uint64_t, LargeValue> >("hotcold-large", workloads[w], keys, writer);
+                }
+                else if (trees[t] == "map"){
+                    runSuite<map<uint64_t, uint64_t> >("map", workloads[w], keys, writer);
+                }
+                else {
+                    usage();
+                }
+            }
+        }
+    }
+    writer.end();
+    return 0;
+}
@@ -0,0 +1,438 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Shared pieces of the tree benchmarks: key workloads, a Zipf generator,
+// per-tree operation wrappers, timers, a latency histogram and CSV/JSON
+// result output.
+
+/**
+ * Order in which a benchmark feeds keys to the tree.
+ */
+enum Workload
+{
+    SEQUENTIAL,   // 0, 1, ..., n-1
+    REVERSE,      // n-1, ..., 1, 0
+    RANDOM,       // a random permutation of 0..n-1
+    ZIPFIAN       // n draws from Zipf(0.99) over 0..n-1, so hot keys repeat
+};
+
+inline const char* workloadName(Workload workload)
+{
+    switch (workload){
+        case SEQUENTIAL: return "sequential";
+        case REVERSE: return "reverse";
+        case RANDOM: return "random";
+        case ZIPFIAN: return "zipfian";
+    }
+    return "unknown";
+}
+
+/**
+ * Zipf distributed integers in [0, n), rank 0 being the most popular,
+ * using the method of Gray et al. ("Quickly generating billion-record
+ * synthetic databases"), as in YCSB. Setup is O(n), each draw is O(1).
+ */
+class ZipfGenerator
+{
+public:
+    ZipfGenerator(uint64_t n, double theta, uint64_t seed) :
+        n_(n), theta_(theta), rng_(seed), uniform_(0.0, 1.0)
+    {
+        double zeta2 = 0;
+        zetan_ = 0;
+        for (uint64_t i = 1; i <= n_; ++i){
+            zetan_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+            if (i == 2) zeta2 = zetan_;
+        }
+        if (n_ < 2) zeta2 = zetan_;
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+    }
+
+    uint64_t next()
+    {
+        double u = uniform_(rng_);
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) return std::min<uint64_t>(1, n_ - 1);
+        uint64_t rank = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(rank, n_ - 1);
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zetan_;
+    double alpha_;
+    double eta_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+};
+
+/**
+ * The n keys a benchmark inserts, looks up and removes for a workload.
+ */
+inline std::vector<uint64_t> workloadKeys(Workload workload, uint64_t n, uint64_t seed)
+{
+    std::vector<uint64_t> keys(n);
+    if (n == 0) return keys;
+    if (workload == ZIPFIAN){
+        ZipfGenerator zipf(n, 0.99, seed);
+        for (uint64_t i = 0; i < n; ++i) keys[i] = zipf.next();
+        return keys;
+    }
+    for (uint64_t i = 0; i < n; ++i){
+        keys[i] = (workload == REVERSE) ? n - 1 - i : i;
+    }
+    if (workload == RANDOM){
+        std::mt19937_64 rng(seed);
+        std::shuffle(keys.begin(), keys.end(), rng);
+    }
+    return keys;
+}
+
+/*
+ * Value type of the "-large" trees: a 256 byte value, the size that makes
+ * inline values crowd the keys and links out of the cache. Converts to and
+ * from uint64_t so the operations below work unchanged.
+ */
+struct LargeValue
+{
+    uint64_t value;
+    char padding[248];
+
+    LargeValue(uint64_t v = 0) : value(v) { }
+    operator uint64_t() const { return value; }
+};
+
+/*
+ * Per-tree operations, so the same benchmark code drives every tree type.
+ */
+template<class Tree>
+void benchInsert(Tree& tree, uint64_t key)
+{
+    tree.insert(std::make_pair(key, key));
+}
+
+inline void benchInsert(std::map<uint64_t, uint64_t>& tree, uint64_t key)
+{
+    tree[key] = key;
+}
+
+template<class Tree>
+void benchRemove(Tree& tree, uint64_t key)
+{
+    tree.remove(key);
+}
+
+inline void benchRemove(std::map<uint64_t, uint64_t>& tree, uint64_t key)
+{
+    tree.erase(key);
+}
+
+template<class Tree>
+uint64_t benchFind(const Tree& tree, uint64_t key)
+{
+    typename Tree::iterator it = tree.find(key);
+    return it == tree.end() ? 0 : static_cast<uint64_t>(it->second);
+}
+
+inline uint64_t benchFind(const std::map<uint64_t, uint64_t>& tree, uint64_t key)
+{
+    std::map<uint64_t, uint64_t>::const_iterator it = tree.find(key);
+    return it == tree.end() ? 0 : it->second;
+}
+
+/*
+ * Looks up keys in order, each search starting from the previous hit
+ * (finger search). Returns the sum of the values found. std::map has no
+ * finger search, so it looks the keys up from the root.
+ */
+template<class Tree>
+uint64_t benchFindFinger(const Tree& tree, const std::vector<uint64_t>& keys)
+{
+    uint64_t sum = 0;
+    typename Tree::iterator finger = tree.end();
+    for (size_t i = 0; i < keys.size(); ++i){
+        typename Tree::iterator it = tree.find(keys[i], finger);
+        if (it != tree.end()){
+            sum += it->second;
+            finger = it;
+        }
+    }
+    return sum;
+}
+
+inline uint64_t benchFindFinger(const std::map<uint64_t, uint64_t>& tree, const std::vector<uint64_t>& keys)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < keys.size(); ++i) sum += benchFind(tree, keys[i]);
+    return sum;
+}
+
+/*
+ * Looks up keys[first, last) as one batch, returning the sum of the values
+ * found. std::map has no batched lookup, so it looks the keys up one by one.
+ */
+template<class Tree>
+uint64_t benchFindBatch(const Tree& tree, const std::vector<uint64_t>& keys, size_t first, size_t last)
+{
+    std::vector<uint64_t> batch(keys.begin() + first, keys.begin() + last);
+    std::vector<typename Tree::iterator> found;
+    tree.find_batch(batch, found);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < found.size(); ++i){
+        if (found[i] != tree.end()) sum += found[i]->second;
+    }
+    return sum;
+}
+
+inline uint64_t benchFindBatch(const std::map<uint64_t, uint64_t>& tree, const std::vector<uint64_t>& keys,
+                               size_t first, size_t last)
+{
+    uint64_t sum = 0;
+    for (size_t i = first; i < last; ++i) sum += benchFind(tree, keys[i]);
+    return sum;
+}
+
+/*
+ * Removes sorted[first, last), a run of consecutive keys, the way a TTL
+ * sweep expires its oldest keys. Trees without range erase find the first
+ * key and erase forward from it; AVLTree's overload is in bench.cpp.
+ */
+template<class Tree>
+void benchEraseRange(Tree& tree, const std::vector<uint64_t>& sorted, size_t first, size_t last)
+{
+    typename Tree::iterator it = tree.find(sorted[first]);
+    for (size_t i = first; i < last; ++i) it = tree.erase(it);
+}
+
+inline void benchEraseRange(std::map<uint64_t, uint64_t>& tree, const std::vector<uint64_t>& sorted,
+                            size_t first, size_t last)
+{
+    std::map<uint64_t, uint64_t>::iterator end =
+        (last < sorted.size()) ? tree.lower_bound(sorted[last]) : tree.end();
+    tree.erase(tree.lower_bound(sorted[first]), end);
+}
+
+/**
+ * Splits a comma separated command line list, dropping empty items.
+ */
+inline std::vector<std::string> splitList(const std::string& text)
+{
+    std::vector<std::string> items;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')){
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+/**
+ * Wall clock stopwatch, started on construction.
+ */
+class Stopwatch
+{
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) { }
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Low overhead tick counter for timing single operations: the TSC where
+ * the CPU has one (__rdtsc, a few ns per read), steady_clock nanoseconds
+ * otherwise. nsPerTick() calibrates ticks against steady_clock once.
+ */
+class CycleClock
+{
+public:
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static double nsPerTick()
+    {
+        static double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t startTicks = now();
+        std::chrono::steady_clock::time_point stop = start + std::chrono::milliseconds(20);
+        while (std::chrono::steady_clock::now() < stop) { }
+        uint64_t ticks = now() - startTicks;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return ticks ? ns / ticks : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+/**
+ * HDR-style log-linear histogram of tick counts. Values below 64 get a
+ * bucket each; above that every power of two is split into 32 linear
+ * sub-buckets, so any recorded value is known to within 1/32 (about 3%)
+ * with a fixed 1920 buckets covering the whole uint64_t range.
+ * record() is a shift and an increment, cheap enough for every operation.
+ */
+class LatencyHistogram
+{
+public:
+    static const int SUB_BITS = 5;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    LatencyHistogram() : counts_(BUCKETS, 0), total_(0), max_(0), sum_(0) { }
+
+    void record(uint64_t value)
+    {
+        ++counts_[bucketOf(value)];
+        ++total_;
+        sum_ += value;
+        if (value > max_) max_ = value;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+
+    /**
+     * Smallest value v such that at least fraction (0..1] of the recorded
+     * values are <= v, up to the bucket resolution. 0 if nothing was recorded.
+     */
+    uint64_t percentile(double fraction) const
+    {
+        if (total_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * total_));
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i){
+            seen += counts_[i];
+            if (seen >= rank) return std::min(highestInBucket(i), max_);
+        }
+        return max_;
+    }
+
+private:
+    static int bucketOf(uint64_t value)
+    {
+        if (value < 2 * SUB_COUNT) return static_cast<int>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BITS;
+        return shift * SUB_COUNT + static_cast<int>(value >> shift);
+    }
+
+    static uint64_t highestInBucket(int bucket)
+    {
+        if (bucket < 2 * SUB_COUNT) return bucket;
+        int shift = bucket / SUB_COUNT - 1;
+        uint64_t low = static_cast<uint64_t>(bucket - shift * SUB_COUNT) << shift;
+        return low + ((uint64_t(1) << shift) - 1);
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    uint64_t max_;
+    uint64_t sum_;
+};
+
+/**
+ * One measured (tree, workload, size, operation) combination.
+ */
+struct BenchResult
+{
+    std::string tree;
+    std::string workload;
+    uint64_t size;
+    std::string op;
+    uint64_t ops;
+    double seconds;
+    std::string status;   // "ok", or why the row was skipped
+};
+
+/**
+ * Prints results as CSV (one header line, one row per result) or as a
+ * JSON array of objects, streaming rows as they are added.
+ */
+class ResultWriter
+{
+public:
+    ResultWriter(std::ostream& out, bool json) : out_(out), json_(json), rows_(0) { }
+
+    void begin()
+    {
+        if (json_) out_ << "[\n";
+        else out_ << "tree,workload,size,op,ops,seconds,ns_per_op,ops_per_sec,status\n";
+    }
+
+    void add(const BenchResult& result)
+    {
+        double nsPerOp = result.ops ? result.seconds * 1e9 / result.ops : 0;
+        double opsPerSec = result.seconds > 0 ? result.ops / result.seconds : 0;
+        if (json_){
+            out_ << (rows_ ? ",\n" : "") << "  {\"tree\": \"" << result.tree
+                 << "\", \"workload\": \"" << result.workload
+                 << "\", \"size\": " << result.size
+                 << ", \"op\": \"" << result.op
+                 << "\", \"ops\": " << result.ops
+                 << ", \"seconds\": " << result.seconds
+                 << ", \"ns_per_op\": " << nsPerOp
+                 << ", \"ops_per_sec\": " << opsPerSec
+                 << ", \"status\": \"" << result.status << "\"}";
+        }
+        else {
+            out_ << result.tree << ',' << result.workload << ',' << result.size << ','
+                 << result.op << ',' << result.ops << ',' << result.seconds << ','
+                 << nsPerOp << ',' << opsPerSec << ',' << result.status << '\n';
+        }
+        out_.flush();
+        ++rows_;
+    }
+
+    void end()
+    {
+        if (json_) out_ << (rows_ ? "\n" : "") << "]\n";
+        out_.flush();
+    }
+
+private:
+    std::ostream& out_;
+    bool json_;
+    uint64_t rows_;
+};
+
+#endif
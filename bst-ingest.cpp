@@ -0,0 +1,233 @@
+// Streaming bulk-ingest tool: reads key/value records from a file or stdin
+// into an AVLTree<int64_t, int64_t> and reports ingest throughput.
+//
+// usage: bst-ingest [--format csv|bin] [--batch N] [file]
+//
+// csv: one record per line
+//     key,value     insert (or overwrite) key
+//     d,key         delete key
+//     blank lines and lines starting with '#' are skipped
+// bin: packed 17-byte records in native byte order
+//     uint8_t op (0 = insert, 1 = delete), int64_t key, int64_t value
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "avlbst.h"
+
+using namespace std;
+
+struct Record
+{
+    int64_t key;
+    int64_t value;
+    bool remove;
+};
+
+bool keyLess(const Record& a, const Record& b)
+{
+    return a.key < b.key;
+}
+
+/**
+ * Reads records through one fixed buffer, so parsing does not allocate
+ * per record. Partial records at the end of the buffer are moved to the
+ * front before the next refill.
+ */
+class RecordReader
+{
+public:
+    RecordReader(FILE* in, bool binary) :
+        in_(in), binary_(binary), buffer_(1 << 20), begin_(0), end_(0), line_(0), eof_(false)
+    {
+
+    }
+
+    // Returns false at end of input. Exits with a message on malformed input.
+    bool next(Record& record)
+    {
+        return binary_ ? nextBinary(record) : nextCsv(record);
+    }
+
+private:
+    static const size_t BIN_RECORD_SIZE = 1 + 2 * sizeof(int64_t);
+
+    // Makes sure at least want bytes are buffered unless the input ends first.
+    // The last byte of the buffer is never filled so a line can always be
+    // NUL-terminated in place.
+    void fill(size_t want)
+    {
+        if (end_ - begin_ >= want || eof_) return;
+        memmove(&buffer_[0], &buffer_[begin_], end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+        while (end_ < want && !eof_){
+            size_t got = fread(&buffer_[end_], 1, buffer_.size() - 1 - end_, in_);
+            if (got == 0) eof_ = true;
+            end_ += got;
+        }
+    }
+
+    bool nextBinary(Record& record)
+    {
+        fill(BIN_RECORD_SIZE);
+        if (begin_ == end_) return false;
+        if (end_ - begin_ < BIN_RECORD_SIZE){
+            cerr << "bst-ingest: truncated binary record at end of input" << endl;
+            exit(1);
+        }
+        const char* p = &buffer_[begin_];
+        record.remove = (p[0] != 0);
+        memcpy(&record.key, p + 1, sizeof(int64_t));
+        memcpy(&record.value, p + 1 + sizeof(int64_t), sizeof(int64_t));
+        begin_ += BIN_RECORD_SIZE;
+        return true;
+    }
+
+    bool nextCsv(Record& record)
+    {
+        while (true){
+            // find a complete line, refilling (and growing for huge lines) as needed
+            char* newline = NULL;
+            while (true){
+                newline = static_cast<char*>(memchr(&buffer_[begin_], '\n', end_ - begin_));
+                if (newline != NULL || eof_) break;
+                if (begin_ == 0 && end_ == buffer_.size() - 1) buffer_.resize(buffer_.size() * 2);
+                fill(end_ - begin_ + 1);
+            }
+            if (begin_ == end_) return false;
+
+            char* start = &buffer_[begin_];
+            char* stop = (newline != NULL) ? newline : &buffer_[0] + end_;
+            begin_ = (newline != NULL) ? (newline - &buffer_[0]) + 1 : end_;
+            ++line_;
+            if (stop > start && stop[-1] == '\r') --stop;
+            if (stop == start || *start == '#') continue;
+
+            *stop = '\0';
+            if (parseCsv(start, record)) return true;
+            cerr << "bst-ingest: malformed record on line " << line_ << ": " << start << endl;
+            exit(1);
+        }
+    }
+
+    // parses a NUL-terminated "key,value" or "d,key" line
+    static bool parseCsv(char* text, Record& record)
+    {
+        char* end = NULL;
+        record.remove = (text[0] == 'd' || text[0] == 'D') && text[1] == ',';
+        if (record.remove){
+            record.key = strtoll(text + 2, &end, 10);
+            record.value = 0;
+            return end != text + 2 && *end == '\0';
+        }
+        record.key = strtoll(text, &end, 10);
+        if (end == text || *end != ',') return false;
+        char* valueStart = end + 1;
+        record.value = strtoll(valueStart, &end, 10);
+        return end != valueStart && *end == '\0';
+    }
+
+    FILE* in_;
+    bool binary_;
+    vector<char> buffer_;
+    size_t begin_;
+    size_t end_;
+    size_t line_;
+    bool eof_;
+};
+
+void usage()
+{
+    cerr << "usage: bst-ingest [--format csv|bin] [--batch N] [file]" << endl;
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    bool binary = false;
+    size_t batchSize = 4096;
+    const char* path = NULL;
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc){
+            string format = argv[++i];
+            if (format == "csv") binary = false;
+            else if (format == "bin") binary = true;
+            else usage();
+        }
+        else if (arg == "--batch" && i + 1 < argc){
+            batchSize = strtoul(argv[++i], NULL, 10);
+            if (batchSize == 0) usage();
+        }
+        else if (path == NULL && (arg == "-" || arg[0] != '-')){
+            path = argv[i];
+        }
+        else {
+            usage();
+        }
+    }
+
+    FILE* in = stdin;
+    if (path != NULL && string(path) != "-"){
+        in = fopen(path, binary ? "rb" : "r");
+        if (in == NULL){
+            perror(path);
+            return 1;
+        }
+    }
+
+    AVLTree<int64_t, int64_t> tree;
+    RecordReader reader(in, binary);
+    vector<Record> batch;
+    batch.reserve(batchSize);
+    uint64_t inserts = 0, removes = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool more = true;
+    while (more){
+        batch.clear();
+        Record record;
+        while (batch.size() < batchSize && (more = reader.next(record))){
+            batch.push_back(record);
+        }
+        // Ops on different keys commute and a stable sort keeps same-key ops
+        // in input order, so sorting only improves locality in the tree.
+        stable_sort(batch.begin(), batch.end(), keyLess);
+        for (size_t i = 0; i < batch.size(); ++i){
+            if (batch[i].remove){
+                tree.remove(batch[i].key);
+                ++removes;
+            }
+            else {
+                tree.insert(make_pair(batch[i].key, batch[i].value));
+                ++inserts;
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (in != stdin) fclose(in);
+
+    struct rusage resources;
+    getrusage(RUSAGE_SELF, &resources);
+    uint64_t records = inserts + removes;
+
+    cout << "records:        " << records << " (" << inserts << " inserts, " << removes << " deletes)" << endl;
+    cout << "seconds:        " << seconds << endl;
+    cout << "records/second: " << (seconds > 0 ? records / seconds : 0) << endl;
+    cout << "peak RSS (KiB): " << resources.ru_maxrss << endl;
+    cout << "final size:     " << tree.size() << endl;
+    cout << "final height:   " << tree.height() << endl;
+    ShapeStats shape = tree.shape_stats();
+    cout << "average depth:  " << shape.averageDepth << endl;
+    cout << "node bytes:     " << shape.bytes() << " (" << shape.heapBytesPerNode << " per node)" << endl;
+    return 0;
+}
@@ -2,6 +2,13 @@
 #include <map>
 #include "bst.h"
 #include "avlbst.h"
+#include "scapegoat.h"
+#include "aggregate_tree.h"
+#include "interval_tree.h"
+#include "hotcold_tree.h"
+#include "avlset.h"
+#include "mapped_tree.h"
+#include <cstdio>
 
 using namespace std;
 
@@ -46,5 +53,119 @@ int main(int argc, char *argv[])
     cout << "Erasing b" << endl;
     at.remove('b');
 
+    cout << "Moving a to a second AVLTree" << endl;
+    AVLTree<char,int> archive;
+    archive.insert(at.extract('a'));
+    cout << "Sizes: " << at.size() << " " << archive.size() << endl;
+    at.merge(archive);
+    cout << "Merged back: " << at.size() << " " << archive.size() << endl;
+
+    // Scapegoat Tree Tests
+    ScapegoatTree<char,int> st;
+    st.insert(std::make_pair('a',1));
+    st.insert(std::make_pair('b',2));
+
+    cout << "\nScapegoatTree contents:" << endl;
+    for(ScapegoatTree<char,int>::iterator it = st.begin(); it != st.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    if(st.find('b') != st.end()) {
+        cout << "Found b" << endl;
+    }
+    else {
+        cout << "Did not find b" << endl;
+    }
+    cout << "Erasing b" << endl;
+    st.remove('b');
+
+    // Aggregate AVL Tree Tests
+    AggregateAVLTree<char,int> agt;
+    agt.insert(std::make_pair('a',1));
+    agt.insert(std::make_pair('b',2));
+    agt.insert(std::make_pair('c',4));
+
+    cout << "\nAggregateAVLTree sums:" << endl;
+    cout << "all: " << agt.aggregate() << endl;
+    cout << "[b, c): " << agt.aggregate('b', 'c') << endl;
+    cout << "Erasing b" << endl;
+    agt.remove('b');
+    cout << "all: " << agt.aggregate() << endl;
+
+    // Interval Tree Tests
+    IntervalTree<int,int> it_tree;
+    it_tree.insert(1, 5, 10);
+    it_tree.insert(4, 8, 20);
+    it_tree.insert(9, 12, 30);
+
+    vector<IntervalTree<int,int>::iterator> hits;
+    it_tree.stab(4, hits);
+    cout << "\nIntervals containing 4:" << endl;
+    for(size_t i = 0; i < hits.size(); ++i) {
+        cout << hits[i]->first << " " << hits[i]->second << endl;
+    }
+    it_tree.overlap(6, 10, hits);
+    cout << "Intervals overlapping [6, 10]:" << endl;
+    for(size_t i = 0; i < hits.size(); ++i) {
+        cout << hits[i]->first << " " << hits[i]->second << endl;
+    }
+
+    // Hot/Cold AVL Tree Tests
+    HotColdAVLTree<char,string> hct;
+    hct.insert(std::make_pair('a',string("apple")));
+    hct.insert(std::make_pair('b',string("banana")));
+    hct['a'] = "apricot";
+
+    cout << "\nHotColdAVLTree contents:" << endl;
+    for(HotColdAVLTree<char,string>::iterator it = hct.begin(); it != hct.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    if(hct.find('b') != hct.end()) {
+        cout << "Found b" << endl;
+    }
+    else {
+        cout << "Did not find b" << endl;
+    }
+    cout << "Erasing b" << endl;
+    hct.remove('b');
+
+    // AVL Set Tests
+    AVLSet<char> as;
+    as.insert('b');
+    as.insert('a');
+    as.insert('c');
+
+    cout << "\nAVLSet contents:" << endl;
+    for(AVLSet<char>::iterator it = as.begin(); it != as.end(); ++it) {
+        cout << *it << endl;
+    }
+    if(as.contains('b')) {
+        cout << "Found b" << endl;
+    }
+    else {
+        cout << "Did not find b" << endl;
+    }
+    cout << "Erasing b" << endl;
+    as.erase('b');
+
+    // Mapped Tree Tests
+    AVLTree<char,int> mt_source;
+    mt_source.insert(std::make_pair('a',1));
+    mt_source.insert(std::make_pair('b',2));
+    MappedTree<char,int>::write(mt_source, "bst-test.idx");
+    MappedTree<char,int> mt("bst-test.idx");
+
+    cout << "\nMappedTree contents:" << endl;
+    for(MappedTree<char,int>::iterator it = mt.begin(); it != mt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    if(mt.find('b') != mt.end()) {
+        cout << "Found b" << endl;
+    }
+    else {
+        cout << "Did not find b" << endl;
+    }
+    mt.close();
+    std::remove("bst-test.idx");
+
     return 0;
 }
@@ -7,6 +7,49 @@
 #include <utility>
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <future>
+#include <thread>
+#include <exception>
+#include <type_traits>
+#include <typeinfo>
+#include "bst_codec.h"
+#include "bst_stats.h"
+#include "bst_validate.h"
+#include "bst_shape.h"
+
+// number of lookups find_batch() keeps in flight at once
+#define BST_BATCH_WIDTH 16
+
+// assign(other, true) only splits trees at least this large across threads
+#define BST_PARALLEL_COPY_MIN 65536
+
+/**
+ * Keys for which the descents (internalFind, locate)
+ * pick the next child with an index instead of an if/else, so random
+ * lookups do not pay for mispredicted branches. Defaults to the
+ * arithmetic types, whose comparisons are cheap and cannot throw;
+ * specialize it to opt other key types in or out. Building with
+ * -DBST_BRANCHY_DESCENT turns it off everywhere, for comparison.
+ */
+template <typename Key>
+struct BranchlessKey
+#ifdef BST_BRANCHY_DESCENT
+    : std::false_type
+#else
+    : std::is_arithmetic<Key>
+#endif
+{
+};
+
+// hint that addr will be read soon
+#if defined(__GNUC__)
+#define BST_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define BST_PREFETCH(addr) ((void)0)
+#endif
 
 /**
  * A templated class for a Node in a search tree.
@@ -195,17 +238,32 @@ template <typename Key, typename Value>
 class BinarySearchTree
 {
 public:
-    BinarySearchTree(); //TODO
+    BinarySearchTree();
+    BinarySearchTree(const BinarySearchTree<Key, Value>& other);
+    BinarySearchTree<Key, Value>& operator=(const BinarySearchTree<Key, Value>& other);
     virtual ~BinarySearchTree(); //TODO
-    virtual void insert(const std::pair<const Key, Value>& keyValuePair); //TODO
-    virtual void remove(const Key& key); //TODO
-    void clear(); //TODO
-    bool isBalanced() const; //TODO
+    virtual void assign(const BinarySearchTree<Key, Value>& other, bool parallel = false);
+    virtual void remove(const Key& key);
+    void clear();
+    bool isBalanced() const;
+    ValidationReport validate(bool parallel = false) const;
+    ShapeStats shape_stats() const;
     void print() const;
     bool empty() const;
+    std::size_t size() const;
+    virtual int height() const;
+    virtual void rebalance();
+    void setRebalanceFactor(double factor);
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
+    const TreeStats& stats() const;
+    void resetStats();
+    void printStats(std::ostream& out) const;
 
     template<typename PPKey, typename PPValue>
     friend void prettyPrintBST(BinarySearchTree<PPKey, PPValue> & tree);
+    template<typename MKey, typename MValue>
+    friend class MappedTree;
 public:
     /**
     * An internal iterator class for traversing the contents of the BST.
@@ -229,17 +287,64 @@ public:
         Node<Key, Value> *current_;
     };
 
+    /**
+    * Owns one node that extract() unlinked from a tree, item and all, until
+    * insert(node_type&&) links it into a tree again. Move-only; an
+    * empty handle owns nothing, and a handle that still owns its node when
+    * destroyed frees it.
+    */
+    class node_type
+    {
+    public:
+        node_type();
+        node_type(node_type&& other);
+        node_type& operator=(node_type&& other);
+        ~node_type();
+
+        bool empty() const;
+        explicit operator bool() const;
+        const Key& key() const;
+        Value& mapped() const;
+
+    protected:
+        friend class BinarySearchTree<Key, Value>;
+        node_type(Node<Key, Value>* node);
+        Node<Key, Value>* node_;
+    };
+
 public:
+    std::pair<iterator, bool> insert(const std::pair<const Key, Value>& keyValuePair);
+    std::pair<iterator, bool> try_insert(const std::pair<const Key, Value>& keyValuePair);
+    iterator erase(iterator pos);
+
+    // Moving items between trees without copying or reallocating them
+    node_type extract(const Key& key);
+    node_type extract(iterator pos);
+    std::pair<iterator, bool> insert(node_type&& handle);
+    void merge(BinarySearchTree<Key, Value>& other);
+
     iterator begin() const;
     iterator end() const;
     iterator find(const Key& key) const;
+    iterator find(const Key& key, iterator hint) const;
+    void find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const;
     Value& operator[](const Key& key);
     Value const & operator[](const Key& key) const;
 
+    // Read-modify-write in one descent: fn(Value&) is applied in place
+    template<typename Fn> bool upsert(const Key& key, Fn fn);
+    template<typename Fn> bool modify(const Key& key, Fn fn);
+
+    // Double-ended priority queue access to the cached smallest and largest items
+    iterator min() const;
+    iterator max() const;
+    void pop_min();
+    void pop_max();
+
 protected:
     // Mandatory helper functions
-    Node<Key, Value>* internalFind(const Key& k) const; // TODO
-    Node<Key, Value> *getSmallestNode() const;  // TODO
+    Node<Key, Value>* internalFind(const Key& k) const;
+    Node<Key, Value> *getSmallestNode() const;
     static Node<Key, Value>* predecessor(Node<Key, Value>* current); // TODO
     // Note:  static means these functions don't have a "this" pointer
     //        and instead just use the input argument.
@@ -248,18 +353,116 @@ protected:
     virtual void printRoot (Node<Key, Value> *r) const;
     virtual void nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2) ;
 
+    // Iterator at n, for subclasses (only this class may construct one from a node)
+    static iterator iteratorAt(Node<Key, Value>* n);
+
+    // Allocates a node of the kind this tree uses
+    virtual Node<Key, Value>* createNode(const Key& key, const Value& value, Node<Key, Value>* parent) const;
+
+    // Unlinks and frees n, a node of this tree: remove() once the key is found
+    void removeNode(Node<Key, Value>* n);
+
+    // Unlinks n, a node of this tree, and rebalances, but leaves n allocated
+    virtual void detachNode(Node<Key, Value>* n);
+
+    // key's node, or a new node linked in if there is none, in a single
+    // descent; inserted tells which. The new node is detached (a node
+    // another tree gave up, holding key and value) if that is not NULL,
+    // else a new allocation of (key, value).
+    virtual Node<Key, Value>* findOrInsert(const Key& key, const Value& value,
+                                           Node<Key, Value>* detached, bool& inserted);
+
+    // Node handle hooks: whether a detached node n is of exactly the type
+    // createNode() allocates, and n made ready to hang below parent (fresh links and
+    // per-node data, as createNode() would give it)
+    virtual bool canAdopt(const Node<Key, Value>* n) const;
+    virtual Node<Key, Value>* adoptNode(Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    Node<Key, Value>* makeNode(const Key& key, const Value& value, Node<Key, Value>* parent,
+                               Node<Key, Value>* detached) const;
+
+    // n's value was changed in place (no-op here, AVLTree updates its
+    // augmentations)
+    virtual void valueChanged(Node<Key, Value>* n);
+
+    // Keep min_/max_ current: after n was linked in as a leaf, before n is
+    // unlinked, and after changes that replace whole subtrees
+    void noteAttached(Node<Key, Value>* n);
+    void noteDetaching(Node<Key, Value>* n);
+    void resetEnds();
+
+    // assign() hooks: a copy of n's item and per-node data (not its links),
+    // and whether other's nodes carry everything cloneNode() copies
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* n, Node<Key, Value>* parent) const;
+    virtual bool canCloneFrom(const BinarySearchTree<Key, Value>& other) const;
+
+    // sizeof the node type createNode() allocates, for shape_stats()
+    virtual std::size_t nodeBytes() const;
+
+    // Per-node invariant of this kind of tree, checked by validate()
+    virtual bool checkNode(const Node<Key, Value>* n, int leftHeight, int rightHeight) const;
+
     // Add helper functions here
     static Node<Key, Value>* successor(Node<Key, Value>* current);
-    void insertHelp(Node<Key, Value>* newPairPtr, Node<Key, Value>* current);
+    Node<Key, Value>* locate(const Key& key, Node<Key, Value>*& parent) const;
+    static void linkLeaf(Node<Key, Value>* n, Node<Key, Value>* parent);
+
+    // Descent kernels, chosen at compile time by BranchlessKey<Key>
+    static Node<Key, Value>* childToward(const Node<Key, Value>* n, const Key& key);
+    Node<Key, Value>* internalFind(const Key& key, std::true_type branchless) const;
+    Node<Key, Value>* internalFind(const Key& key, std::false_type branchless) const;
+    Node<Key, Value>* locate(const Key& key, Node<Key, Value>*& parent, std::true_type branchless) const;
+    Node<Key, Value>* locate(const Key& key, Node<Key, Value>*& parent, std::false_type branchless) const;
 		int getHeight(Node<Key, Value>* curr_node) const;
-        bool isBalancedHelp(Node<Key, Value>* curr_node) const;
 		Node<Key, Value> *getLargestNode() const;
         void clearHelp(Node<Key, Value>* current);
 
+    // In-place subtree rebuilding (Day-Stout-Warren), no allocations
+    static Node<Key, Value>* treeToVine(Node<Key, Value>* sub, std::size_t& count);
+    static Node<Key, Value>* vineToTree(Node<Key, Value>* head, std::size_t count);
+    static Node<Key, Value>* compressVine(Node<Key, Value>* head, std::size_t count);
+    Node<Key, Value>* rebuildSubtree(Node<Key, Value>* sub);
+
+    // assign() helpers: structural copies of detached subtrees
+    Node<Key, Value>* cloneSubtree(const Node<Key, Value>* src, Node<Key, Value>* parent) const;
+    Node<Key, Value>* cloneParallel(const Node<Key, Value>* src) const;
+    Node<Key, Value>* cloneTop(const Node<Key, Value>* src, Node<Key, Value>* parent, int depth, int splitDepth,
+                               std::vector<std::pair<const Node<Key, Value>*, Node<Key, Value>*> >& parts) const;
+    static std::size_t deleteSubtree(Node<Key, Value>* sub);
+
+    // validate() helpers: what a validated subtree looks like from its parent
+    struct SubtreeSummary
+    {
+        Node<Key, Value>* min;
+        Node<Key, Value>* max;
+        int height;
+        std::size_t count;
+    };
+    typedef std::pair<SubtreeSummary, ValidationReport> ValidatedPart;
+    SubtreeSummary validateNode(Node<Key, Value>* n, const SubtreeSummary& left,
+                                const SubtreeSummary& right, ValidationReport& report) const;
+    SubtreeSummary validateSubtree(Node<Key, Value>* sub, ValidationReport& report) const;
+    ValidatedPart validatePart(Node<Key, Value>* sub) const;
+    void splitForValidation(Node<Key, Value>* n, int depth, int splitDepth,
+                            std::vector<Node<Key, Value>*>& parts) const;
+    SubtreeSummary validateTop(Node<Key, Value>* n, int depth, int splitDepth,
+                               std::vector<std::future<ValidatedPart> >& parts,
+                               std::size_t& next, ValidationReport& report) const;
+
 
 protected:
     Node<Key, Value>* root_;
-    // You should not need other data members
+    // number of nodes currently in the tree
+    std::size_t size_;
+    // insert() rebalances once height exceeds this multiple of log2(n), 0 = never
+    double rebalanceFactor_;
+    // leftmost and rightmost nodes, NULL when empty. Rotations and node
+    // swaps move nodes but never change which node holds the smallest key.
+    Node<Key, Value>* min_;
+    Node<Key, Value>* max_;
+#ifdef BST_STATS
+    // hot-path counters, see bst_stats.h
+    mutable TreeStats stats_;
+#endif
 };
 
 /*
@@ -365,6 +568,90 @@ End implementations for the BinarySearchTree::iterator class.
 -------------------------------------------------------------
 */
 
+/*
+--------------------------------------------------------------
+Begin implementations for the BinarySearchTree::node_type class.
+--------------------------------------------------------------
+*/
+
+template<class Key, class Value>
+BinarySearchTree<Key, Value>::node_type::node_type() :
+    node_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+BinarySearchTree<Key, Value>::node_type::node_type(Node<Key, Value>* node) :
+    node_(node)
+{
+
+}
+
+template<class Key, class Value>
+BinarySearchTree<Key, Value>::node_type::node_type(node_type&& other) :
+    node_(other.node_)
+{
+    other.node_ = NULL;
+}
+
+/**
+* Frees the node this handle owns, if any, and takes over other's
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::node_type&
+BinarySearchTree<Key, Value>::node_type::operator=(node_type&& other)
+{
+    if (this != &other){
+        delete node_;
+        node_ = other.node_;
+        other.node_ = NULL;
+    }
+    return *this;
+}
+
+template<class Key, class Value>
+BinarySearchTree<Key, Value>::node_type::~node_type()
+{
+    delete node_;
+}
+
+template<class Key, class Value>
+bool BinarySearchTree<Key, Value>::node_type::empty() const
+{
+    return node_ == NULL;
+}
+
+template<class Key, class Value>
+BinarySearchTree<Key, Value>::node_type::operator bool() const
+{
+    return node_ != NULL;
+}
+
+/**
+* @precondition The handle is not empty
+*/
+template<class Key, class Value>
+const Key& BinarySearchTree<Key, Value>::node_type::key() const
+{
+    return node_->getKey();
+}
+
+/**
+* @precondition The handle is not empty
+*/
+template<class Key, class Value>
+Value& BinarySearchTree<Key, Value>::node_type::mapped() const
+{
+    return node_->getValue();
+}
+
+/*
+------------------------------------------------------------
+End implementations for the BinarySearchTree::node_type class.
+------------------------------------------------------------
+*/
+
 /*
 -----------------------------------------------------
 Begin implementations for the BinarySearchTree class.
@@ -377,9 +664,32 @@ Begin implementations for the BinarySearchTree class.
 template<class Key, class Value>
 BinarySearchTree<Key, Value>::BinarySearchTree() 
 {
-    // TODO
     root_ = NULL;
+    size_ = 0;
+    rebalanceFactor_ = 0;
+    min_ = NULL;
+    max_ = NULL;
+
+}
+
+/**
+ * Copy constructor, see assign()
+ */
+template<typename Key, typename Value>
+BinarySearchTree<Key, Value>::BinarySearchTree(const BinarySearchTree<Key, Value>& other) :
+    root_(NULL), size_(0), rebalanceFactor_(0), min_(NULL), max_(NULL)
+{
+    assign(other);
+}
 
+/**
+ * Assignment operator, see assign()
+ */
+template<typename Key, typename Value>
+BinarySearchTree<Key, Value>& BinarySearchTree<Key, Value>::operator=(const BinarySearchTree<Key, Value>& other)
+{
+    assign(other);
+    return *this;
 }
 
 template<typename Key, typename Value>
@@ -398,6 +708,15 @@ bool BinarySearchTree<Key, Value>::empty() const
     return root_ == NULL;
 }
 
+/**
+ * Returns the number of nodes in the tree
+*/
+template<class Key, class Value>
+std::size_t BinarySearchTree<Key, Value>::size() const
+{
+    return size_;
+}
+
 template<typename Key, typename Value>
 void BinarySearchTree<Key, Value>::print() const
 {
@@ -406,7 +725,7 @@ void BinarySearchTree<Key, Value>::print() const
 }
 
 /**
-* Returns an iterator to the "smallest" item in the tree
+* Returns an iterator to the "smallest" item in the tree, O(1)
 */
 template<class Key, class Value>
 typename BinarySearchTree<Key, Value>::iterator
@@ -427,6 +746,56 @@ BinarySearchTree<Key, Value>::end() const
     return end;
 }
 
+/**
+* Returns an iterator to the smallest item, end() if the tree is empty. O(1)
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::min() const
+{
+    return iterator(min_);
+}
+
+/**
+* Returns an iterator to the largest item, end() if the tree is empty. O(1)
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::max() const
+{
+    return iterator(max_);
+}
+
+/**
+* Removes the smallest item, if any, without searching for its key
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::pop_min()
+{
+    BST_STAT(++stats_.removes);
+    if (min_ != NULL) removeNode(min_);
+}
+
+/**
+* Removes the largest item, if any, without searching for its key
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::pop_max()
+{
+    BST_STAT(++stats_.removes);
+    if (max_ != NULL) removeNode(max_);
+}
+
+/**
+* Returns an iterator at node n (end() for NULL)
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::iteratorAt(Node<Key, Value>* n)
+{
+    return iterator(n);
+}
+
 /**
 * Returns an iterator to the item with the given key, k
 * or the end iterator if k does not exist in the tree
@@ -435,22 +804,137 @@ template<class Key, class Value>
 typename BinarySearchTree<Key, Value>::iterator
 BinarySearchTree<Key, Value>::find(const Key & k) const
 {
+    BST_STAT(++stats_.finds);
     Node<Key, Value> *curr = internalFind(k);
     BinarySearchTree<Key, Value>::iterator it(curr);
     return it;
 }
 
 /**
- * @precondition The key exists in the map
- * Returns the value associated with the key
+* Finger search: returns an iterator to key, or end() if it is not in the
+* tree, starting from hint (typically the result of the previous lookup)
+* instead of the root. It climbs from hint only until the subtree it is in
+* must contain key, then descends, so for nearby keys the cost depends on
+* their rank distance d rather than on the tree size: O(log d) in a
+* balanced tree, except that keys on opposite sides of a high ancestor
+* still climb to that ancestor. hint == end() searches from the root.
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::find(const Key& key, iterator hint) const
+{
+    if (hint.current_ == NULL) return find(key);
+    BST_STAT(++stats_.finds);
+
+    Node<Key, Value>* n = hint.current_;
+    while (true){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+        if (key < n->getKey()){
+            // n's subtree holds the keys between the ancestor n hangs right of and n
+            Node<Key, Value>* p = n->getParent();
+            if (p == NULL || (p->getRight() == n && p->getKey() < key)) break;
+            n = p;
+        }
+        else if (n->getKey() < key){
+            Node<Key, Value>* p = n->getParent();
+            if (p == NULL || (p->getLeft() == n && key < p->getKey())) break;
+            n = p;
+        }
+        else {
+            return iterator(n);
+        }
+    }
+
+    while (n != NULL){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+        if (key < n->getKey()){
+            n = n->getLeft();
+        }
+        else if (n->getKey() < key){
+            n = n->getRight();
+        }
+        else {
+            break;
+        }
+    }
+    return iterator(n);
+}
+
+/**
+* Looks up every key in keys, storing in out[i] an iterator to keys[i]
+* or end() if it is not in the tree.
+* Independent descents are interleaved, BST_BATCH_WIDTH at a time: each
+* round advances every in-flight lookup by one level and prefetches the
+* node it will compare against next round, so the cache misses of
+* different lookups overlap instead of being paid one after another.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const
+{
+    out.assign(keys.size(), end());
+    BST_STAT(stats_.finds += keys.size());
+    if (empty()) return;
+
+    // in-flight lookups: the index of the key and the node to compare it with next
+    std::size_t slotKey[BST_BATCH_WIDTH];
+    Node<Key, Value>* slotNode[BST_BATCH_WIDTH];
+    std::size_t active = 0, next = 0;
+    while (active < BST_BATCH_WIDTH && next < keys.size()){
+        slotKey[active] = next++;
+        slotNode[active++] = root_;
+    }
+
+    while (active > 0){
+        std::size_t i = 0;
+        while (i < active){
+            const Key& key = keys[slotKey[i]];
+            Node<Key, Value>* n = slotNode[i];
+            BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+            if (key < n->getKey()){
+                n = n->getLeft();
+            }
+            else if (n->getKey() < key){
+                n = n->getRight();
+            }
+            else {
+                out[slotKey[i]] = iterator(n);
+                n = NULL;
+            }
+
+            if (n != NULL){
+                BST_PREFETCH(n);
+                slotNode[i++] = n;
+            }
+            // this lookup is done: start the next key in its slot...
+            else if (next < keys.size()){
+                slotKey[i] = next++;
+                slotNode[i++] = root_;
+            }
+            // ...or retire the slot by moving the last one into it
+            else {
+                --active;
+                slotKey[i] = slotKey[active];
+                slotNode[i] = slotNode[active];
+            }
+        }
+    }
+}
+
+/**
+ * Returns the value associated with the key, inserting Value() first if
+ * the key is missing (like std::map), in a single descent
  */
 template<class Key, class Value>
 Value& BinarySearchTree<Key, Value>::operator[](const Key& key)
 {
-    Node<Key, Value> *curr = internalFind(key);
-    if(curr == NULL) throw std::out_of_range("Invalid key");
-    return curr->getValue();
+    bool inserted;
+    return findOrInsert(key, Value(), NULL, inserted)->getValue();
 }
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
 template<class Key, class Value>
 Value const & BinarySearchTree<Key, Value>::operator[](const Key& key) const
 {
@@ -464,145 +948,382 @@ Value const & BinarySearchTree<Key, Value>::operator[](const Key& key) const
 * The tree will not remain balanced when inserting.
 * Recall: If key is already in the tree, you should 
 * overwrite the current value with the updated value.
+* Returns an iterator to key's item and whether key was new, so callers
+* need no find() to reach the node they just wrote.
+* Not virtual: subclasses hook findOrInsert() and valueChanged(), which
+* leaves them free to hide insert() behind their own iterator type.
 */
 template<class Key, class Value>
-void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &keyValuePair)
+std::pair<typename BinarySearchTree<Key, Value>::iterator, bool>
+BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &keyValuePair)
 {
-    // TODO
+    BST_STAT(++stats_.inserts);
 
-    // when root is null
-    if (empty()){
-        Node<Key, Value>* newnode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, nullptr);
-				root_ = newnode;
-    }
+    bool inserted;
+    Node<Key, Value>* n = findOrInsert(keyValuePair.first, keyValuePair.second, NULL, inserted);
     // if key already in tree, update its value
-    else if (internalFind(keyValuePair.first) != NULL){
-        internalFind(keyValuePair.first)->setValue(keyValuePair.second);
-    }
-    // if not in tree
-    else{
-        // traverse > or < with helper function
-        Node<Key, Value>* newnode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, nullptr);
-				insertHelp(newnode, root_);
+    if (!inserted){
+        n->setValue(keyValuePair.second);
+        valueChanged(n);
     }
+    return std::make_pair(iterator(n), inserted);
 }
 
 /**
-* An insert method helper functions
+* Like insert(), but an existing key keeps its value
 */
 template<class Key, class Value>
-void BinarySearchTree<Key, Value>::insertHelp(Node<Key, Value>* newPairPtr, Node<Key, Value>* current)
+std::pair<typename BinarySearchTree<Key, Value>::iterator, bool>
+BinarySearchTree<Key, Value>::try_insert(const std::pair<const Key, Value> &keyValuePair)
 {
-	// base case: leaf node reached, val is < leaf
-	if (current->getLeft() == NULL && newPairPtr->getKey() < current->getKey()){
-        current->setLeft(newPairPtr);
-		newPairPtr->setParent(current);
-        return;
-	}
-	// base case 2: leaf node reached, val is > leaf
-	else if (current->getRight() == NULL && newPairPtr->getKey() > current->getKey()){
-        current->setRight(newPairPtr);
-		newPairPtr->setParent(current);
-        return;
-	}
-	// left traversal necesssary, left child exists
-	else if (newPairPtr->getKey() < current->getKey()){
-		insertHelp(newPairPtr, current->getLeft());
-	}
-	// right traversal necesssary, right child exists
-	else if (newPairPtr->getKey() > current->getKey()){
-		insertHelp(newPairPtr, current->getRight());
-	}
+    BST_STAT(++stats_.inserts);
+
+    bool inserted;
+    Node<Key, Value>* n = findOrInsert(keyValuePair.first, keyValuePair.second, NULL, inserted);
+    return std::make_pair(iterator(n), inserted);
 }
 
+/**
+* Finds key, inserting Value() first if it is missing, and applies fn to
+* the value in place: fn(Value&). Returns true if key was inserted. A
+* counter update is tree.upsert(key, increment) instead of a find() and an
+* insert(), each descending from the root. If fn throws, a newly inserted
+* key keeps Value().
+*/
+template<class Key, class Value>
+template<typename Fn>
+bool BinarySearchTree<Key, Value>::upsert(const Key& key, Fn fn)
+{
+    BST_STAT(++stats_.inserts);
+    bool inserted;
+    Node<Key, Value>* n = findOrInsert(key, Value(), NULL, inserted);
+    fn(n->getValue());
+    valueChanged(n);
+    return inserted;
+}
 
 /**
-* A remove method to remove a specific key from a Binary Search Tree.
-* Recall: The writeup specifies that if a node has 2 children you
-* should swap with the predecessor and then remove.
+* Applies fn(Value&) in place to key's value. Returns false, without
+* calling fn, if key is not in the tree.
 */
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::remove(const Key& key)
+template<class Key, class Value>
+template<typename Fn>
+bool BinarySearchTree<Key, Value>::modify(const Key& key, Fn fn)
 {
-    // TODO
+    BST_STAT(++stats_.finds);
+    Node<Key, Value>* n = internalFind(key);
+    if (n == NULL) return false;
+    fn(n->getValue());
+    valueChanged(n);
+    return true;
+}
 
-    Node<Key, Value>* target = internalFind(key);
-    // if key exists
-    if (target != NULL) {
-        // if key has two children, swap with predecessor then remove
-        if (target->getRight() != nullptr && target->getLeft() != nullptr) {
-            Node<Key, Value>* pred = predecessor(target);
-            nodeSwap(target, pred);
-            if (root_ == target){
-                root_ = pred;
-            }
-        }
-        if (target->getRight() == nullptr && target->getLeft() == nullptr){
-            // making sure root_ still exists if tree only has root_
-            // because this is when the node to be removed specifically
-            // has no children either
-            if (root_ == target){
-							delete target;
-                root_ = NULL;
-            }
-            else {
-                // target->setParent(nullptr);
-								if (target->getParent()->getRight() == target){
-									target->getParent()->setRight(nullptr);
-								}
-								else{
-									target->getParent()->setLeft(nullptr);
-								}
-                delete target;
-            }
+/**
+* insert()/upsert()/operator[] helper function
+* one descent that either finds key or links a new leaf where it belongs.
+* The tree will not remain balanced when inserting.
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::findOrInsert(const Key& key, const Value& value,
+                                                             Node<Key, Value>* detached, bool& inserted)
+{
+    Node<Key, Value>* parent;
+    Node<Key, Value>* n = locate(key, parent);
+    inserted = (n == NULL);
+    if (!inserted) return n;
+
+    n = makeNode(key, value, parent, detached);
+    if (parent == NULL) root_ = n;
+    else linkLeaf(n, parent);
+    noteAttached(n);
+    ++size_;
+    // automatic rebalance once the new node sits too deep (root is height 1)
+    if (rebalanceFactor_ > 0){
+        int depth = 1;
+        for (Node<Key, Value>* p = parent; p != NULL; p = p->getParent()) ++depth;
+        if (depth > rebalanceFactor_ * std::log2(static_cast<double>(size_))){
+            rebalance();
         }
-        // if key has only left child, remove key, promote single child
-        else if (target->getLeft() != NULL && target->getRight() == NULL){
-            // check if node has a partent, and thus is the root
-            if (root_ == target){
-                Node<Key, Value>* newTarget = target->getLeft();
+    }
+    return n;
+}
 
-                root_ = newTarget;
-                newTarget->setParent(nullptr);
-            }
-            else {
-                Node<Key, Value>* newTarget = target->getLeft();
-                Node<Key, Value>* oldParent = target->getParent();
-                
-                newTarget->setParent(oldParent);
+/**
+* Hook for values changed in place by insert(), upsert() and modify()
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::valueChanged(Node<Key, Value>*)
+{
 
-								if (newTarget->getKey() > oldParent->getKey()){
-									oldParent->setRight(newTarget);
-								}
-								else{
-									oldParent->setLeft(newTarget);
-								}
-            }
-            delete target;
-        }
-        // if key has only right child
-        else if (target->getLeft() == NULL && target->getRight() != NULL){
-            // check if node has a partent, and thus is the root
-            if (root_ == target){
-                Node<Key, Value>* newTarget = target->getRight();
+}
 
-                root_ = newTarget;
-                newTarget->setParent(nullptr);
-            }
-            else {
-                Node<Key, Value>* newTarget = target->getRight();
-                Node<Key, Value>* oldParent = target->getParent();
+/**
+* Descent shared by the inserting operations: returns key's node, or NULL
+* with parent set to the node a new leaf for key hangs below (NULL for an
+* empty tree)
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::locate(const Key& key, Node<Key, Value>*& parent) const
+{
+    return locate(key, parent, BranchlessKey<Key>());
+}
+
+/**
+* locate() for BranchlessKey keys (see childToward())
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::locate(const Key& key, Node<Key, Value>*& parent, std::true_type) const
+{
+    parent = NULL;
+    Node<Key, Value>* n = root_;
+    while (n != NULL){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+        if (n->getKey() == key) return n;
+        parent = n;
+        n = childToward(n, key);
+    }
+    return NULL;
+}
+
+/**
+* locate() for other keys
+*/
+template<class Key, class Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::locate(const Key& key, Node<Key, Value>*& parent, std::false_type) const
+{
+    parent = NULL;
+    Node<Key, Value>* n = root_;
+    while (n != NULL){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+        if (key < n->getKey()){
+            parent = n;
+            n = n->getLeft();
+        }
+        else if (n->getKey() < key){
+            parent = n;
+            n = n->getRight();
+        }
+        else {
+            return n;
+        }
+    }
+    return NULL;
+}
+
+/**
+* Hangs the new leaf n below parent, on the side its key belongs
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::linkLeaf(Node<Key, Value>* n, Node<Key, Value>* parent)
+{
+    if (parent->getKey() < n->getKey()) parent->setRight(n);
+    else parent->setLeft(n);
+    n->setParent(parent);
+}
+
+
+/**
+* A remove method to remove a specific key from a Binary Search Tree.
+* Recall: The writeup specifies that if a node has 2 children you
+* should swap with the predecessor and then remove.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::remove(const Key& key)
+{
+    BST_STAT(++stats_.removes);
+
+    Node<Key, Value>* target = internalFind(key);
+    // if key exists
+    if (target != NULL) {
+        removeNode(target);
+    }
+}
+
+/**
+* Removes the item at pos without searching for its key and returns an
+* iterator to the item after it (end() if there is none, or if pos is
+* end()). Other iterators stay valid; only pos is invalidated.
+*/
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::erase(iterator pos)
+{
+    Node<Key, Value>* n = pos.current_;
+    if (n == NULL) return end();
+    BST_STAT(++stats_.removes);
+    // removeNode() relinks nodes but never moves items between them
+    Node<Key, Value>* next = successor(n);
+    removeNode(n);
+    return iterator(next);
+}
+
+/**
+* Unlinks key's node and hands it over, item and all, without copying or
+* freeing anything. Returns an empty handle if key is not in the tree.
+*/
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::node_type
+BinarySearchTree<Key, Value>::extract(const Key& key)
+{
+    return extract(find(key));
+}
+
+/**
+* extract() for the node at pos, without searching for its key (an empty
+* handle for end())
+*/
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::node_type
+BinarySearchTree<Key, Value>::extract(iterator pos)
+{
+    Node<Key, Value>* n = pos.current_;
+    if (n == NULL) return node_type();
+    BST_STAT(++stats_.removes);
+    detachNode(n);
+    return node_type(n);
+}
+
+/**
+* Links the handle's node into this tree in one descent, with no
+* allocation, and empties the handle. If the key is already in the tree
+* (or the handle is empty) nothing changes and the handle keeps its node.
+* Returns the key's position and whether the node went in, like insert().
+* Throws std::invalid_argument if the node came from a different kind of
+* tree (e.g. a plain BinarySearchTree's node into an AVLTree).
+*/
+template<typename Key, typename Value>
+std::pair<typename BinarySearchTree<Key, Value>::iterator, bool>
+BinarySearchTree<Key, Value>::insert(node_type&& handle)
+{
+    Node<Key, Value>* node = handle.node_;
+    if (node == NULL) return std::make_pair(end(), false);
+    if (!canAdopt(node)){
+        throw std::invalid_argument("BinarySearchTree::insert: node is from a different kind of tree");
+    }
+    BST_STAT(++stats_.inserts);
+    bool inserted;
+    Node<Key, Value>* n = findOrInsert(node->getKey(), node->getValue(), node, inserted);
+    if (inserted) handle.node_ = NULL;
+    return std::make_pair(iterator(n), inserted);
+}
+
+/**
+* Moves every node of other whose key is not in this tree over to this
+* tree, relinking the nodes (no copies, no allocations). Keys this tree
+* already has stay in other. Throws std::invalid_argument, moving nothing,
+* if other is a different kind of tree.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::merge(BinarySearchTree<Key, Value>& other)
+{
+    if (&other == this || other.root_ == NULL) return;
+    if (!canAdopt(other.root_)){
+        throw std::invalid_argument("BinarySearchTree::merge: other is a different kind of tree");
+    }
+    Node<Key, Value>* n = other.min_;
+    while (n != NULL){
+        // detaching and relinking never move items between nodes
+        Node<Key, Value>* next = successor(n);
+        other.detachNode(n);
+        bool inserted;
+        findOrInsert(n->getKey(), n->getValue(), n, inserted);
+        if (!inserted){
+            other.findOrInsert(n->getKey(), n->getValue(), n, inserted);
+        }
+        n = next;
+    }
+}
+
+/**
+* remove() helper function
+* unlinks and frees target
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::removeNode(Node<Key, Value>* target)
+{
+    detachNode(target);
+    delete target;
+}
+
+/**
+* removeNode() and extract() helper function
+* unlinks target without freeing it, swapping it with its predecessor
+* first if it has two children
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::detachNode(Node<Key, Value>* target)
+{
+    noteDetaching(target);
+    --size_;
+    // if key has two children, swap with predecessor then remove
+    if (target->getRight() != nullptr && target->getLeft() != nullptr) {
+        Node<Key, Value>* pred = predecessor(target);
+        nodeSwap(target, pred);
+        if (root_ == target){
+            root_ = pred;
+        }
+    }
+    if (target->getRight() == nullptr && target->getLeft() == nullptr){
+        // making sure root_ still exists if tree only has root_
+        // because this is when the node to be removed specifically
+        // has no children either
+        if (root_ == target){
+            root_ = NULL;
+        }
+        else {
+            // target->setParent(nullptr);
+								if (target->getParent()->getRight() == target){
+									target->getParent()->setRight(nullptr);
+								}
+								else{
+									target->getParent()->setLeft(nullptr);
+								}
+        }
+    }
+    // if key has only left child, remove key, promote single child
+    else if (target->getLeft() != NULL && target->getRight() == NULL){
+        // check if node has a partent, and thus is the root
+        if (root_ == target){
+            Node<Key, Value>* newTarget = target->getLeft();
+
+            root_ = newTarget;
+            newTarget->setParent(nullptr);
+        }
+        else {
+            Node<Key, Value>* newTarget = target->getLeft();
+            Node<Key, Value>* oldParent = target->getParent();
+            
+            newTarget->setParent(oldParent);
 
-                newTarget->setParent(oldParent);
-                
 								if (newTarget->getKey() > oldParent->getKey()){
 									oldParent->setRight(newTarget);
 								}
 								else{
 									oldParent->setLeft(newTarget);
 								}
-            }
-            delete target;
+        }
+    }
+    // if key has only right child
+    else if (target->getLeft() == NULL && target->getRight() != NULL){
+        // check if node has a partent, and thus is the root
+        if (root_ == target){
+            Node<Key, Value>* newTarget = target->getRight();
+
+            root_ = newTarget;
+            newTarget->setParent(nullptr);
+        }
+        else {
+            Node<Key, Value>* newTarget = target->getRight();
+            Node<Key, Value>* oldParent = target->getParent();
+
+            newTarget->setParent(oldParent);
+            
+								if (newTarget->getKey() > oldParent->getKey()){
+									oldParent->setRight(newTarget);
+								}
+								else{
+									oldParent->setLeft(newTarget);
+								}
         }
     }
 }
@@ -686,9 +1407,11 @@ BinarySearchTree<Key, Value>::successor(Node<Key, Value>* current)
 template<typename Key, typename Value>
 void BinarySearchTree<Key, Value>::clear()
 {
-    // TODO
     clearHelp(root_);
     root_ = NULL;
+    size_ = 0;
+    min_ = NULL;
+    max_ = NULL;
 }
 
 
@@ -713,42 +1436,75 @@ void BinarySearchTree<Key, Value>::clearHelp(Node<Key, Value>* current)
 
 
 /**
-* A helper function to find the smallest node in the tree.
+* A helper function to find the smallest node in the tree. O(1): the node
+* is cached in min_.
 */
 template<typename Key, typename Value>
 Node<Key, Value>*
 BinarySearchTree<Key, Value>::getSmallestNode() const
 {
-    // TODO
-    // if this is null
-    if (root_ == nullptr) return nullptr;
-    // if there is no left
-    if (root_->getLeft() == NULL) return root_;
-    // if there is a left
-    Node<Key, Value>* temp = root_;
-    while (temp->getLeft() != NULL){
-        temp = temp->getLeft();
-    }
-    return temp;
+    return min_;
 }
 
 /**
-* A helper function to find the largest node in the tree.
+* A helper function to find the largest node in the tree, cached in max_.
 */
 template<typename Key, typename Value>
 Node<Key, Value>*
 BinarySearchTree<Key, Value>::getLargestNode() const
 {
-    // if this is null
-    if (root_ == nullptr) return nullptr;
-    // if there is no right
-    if (root_->getRight() == NULL) return root_;
-    // if there is a right
-    Node<Key, Value>* temp = root_;
-    while (temp->getRight() != NULL){
-        temp = temp->getRight();
+    return max_;
+}
+
+/**
+* Updates min_/max_ for n, just linked in as a leaf (or as the root of an
+* empty tree). n is the new smallest node exactly when it hangs left of the
+* old one, so this needs no key comparisons.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::noteAttached(Node<Key, Value>* n)
+{
+    Node<Key, Value>* parent = n->getParent();
+    if (parent == NULL){
+        min_ = n;
+        max_ = n;
+    }
+    else if (parent == min_ && parent->getLeft() == n){
+        min_ = n;
+    }
+    else if (parent == max_ && parent->getRight() == n){
+        max_ = n;
+    }
+}
+
+/**
+* Updates min_/max_ for n, about to be unlinked. The smallest node has no
+* left child, so its successor is at most one subtree walk away.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::noteDetaching(Node<Key, Value>* n)
+{
+    if (n == min_) min_ = successor(n);
+    if (n == max_) max_ = predecessor(n);
+}
+
+/**
+* Finds min_/max_ again by walking down from the root, O(height)
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::resetEnds()
+{
+    min_ = root_;
+    max_ = root_;
+    if (root_ == NULL) return;
+    while (min_->getLeft() != NULL){
+        BST_STAT(++stats_.nodesVisited);
+        min_ = min_->getLeft();
+    }
+    while (max_->getRight() != NULL){
+        BST_STAT(++stats_.nodesVisited);
+        max_ = max_->getRight();
     }
-    return temp;
 }
 
 /**
@@ -759,23 +1515,63 @@ BinarySearchTree<Key, Value>::getLargestNode() const
 template<typename Key, typename Value>
 Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) const
 {
-    // TODO
+    return internalFind(key, BranchlessKey<Key>());
+}
+
+/**
+* The child of n on key's side (left for key == n's key), chosen by
+* indexing rather than branching. The getters are called non-virtually:
+* every node type keeps its links in Node.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::childToward(const Node<Key, Value>* n, const Key& key)
+{
+    Node<Key, Value>* const children[2] = { n->Node<Key, Value>::getLeft(), n->Node<Key, Value>::getRight() };
+    return children[n->getKey() < key];
+}
+
+/**
+* internalFind() for BranchlessKey keys. The only branch per level is the
+* equality test, which stays predictable: it fails until the very end.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key, std::true_type) const
+{
+    Node<Key, Value>* temp = root_;
+    while (temp != NULL){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
+        if (temp->getKey() == key) return temp;
+        temp = childToward(temp, key);
+    }
+    return NULL;
+}
+
+/**
+* internalFind() for other keys
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key, std::false_type) const
+{
+    if (empty()) return NULL;
 
     const Key& max = getLargestNode()->getKey();
     const Key& min = getSmallestNode()->getKey();
     
-    if (empty() || key > max || key < min){
+    BST_STAT(stats_.comparisons += 2);
+    if (key > max || key < min){
         return NULL;
     }
 
     Node<Key, Value>* temp = root_; 
     while (temp->getKey() != key){
+        BST_STAT((++stats_.nodesVisited, stats_.comparisons += 2));
 		// traverse left
         if (key < temp->getKey()){
             temp = temp->getLeft();
         }
 		// traverse right
         else if (key > temp->getKey()){
+            BST_STAT(++stats_.comparisons);
             temp = temp->getRight();
         }
 
@@ -783,27 +1579,242 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) con
         if (temp == nullptr) return NULL;
     }
 	// when while loop exited: thus, key found
+    BST_STAT((++stats_.nodesVisited, ++stats_.comparisons));
     return temp;
     
 }
 
 
+/**
+ * Returns the number of levels in the tree (0 when empty)
+ */
+template<typename Key, typename Value>
+int BinarySearchTree<Key, Value>::height() const
+{
+    return getHeight(root_);
+}
+
+/**
+ * Restructures the existing nodes into a complete tree (minimal height)
+ * in O(n) time with O(1) extra memory and no allocations.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::rebalance()
+{
+    rebuildSubtree(root_);
+}
+
+/**
+ * Makes insert() call rebalance() whenever a new node lands deeper than
+ * factor * log2(n) levels. Each rebalance is O(n), so keep the factor well
+ * above 1 (e.g. 2 or 3) to amortize it; 0 turns automatic rebalancing off.
+ * For a large sorted load it is cheaper to insert everything with the
+ * factor at 0 and call rebalance() once at the end.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::setRebalanceFactor(double factor)
+{
+    rebalanceFactor_ = factor;
+}
+
+/**
+ * Writes every pair, in increasing key order, as a checksummed binary
+ * snapshot (layout in bst_codec.h). Keys and values are encoded with
+ * BinaryCodec, which writes trivially copyable types raw.
+ * Throws std::runtime_error if the stream fails.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::save(std::ostream& out) const
+{
+    ChecksumStreamBuf checksum(out.rdbuf());
+    std::ostream body(&checksum);
+
+    body.write(BST_SNAPSHOT_MAGIC, 4);
+    BinaryCodec<uint32_t>::write(body, BST_SNAPSHOT_VERSION);
+    BinaryCodec<uint32_t>::write(body, static_cast<uint32_t>(BinaryCodec<Key>::width));
+    BinaryCodec<uint32_t>::write(body, static_cast<uint32_t>(BinaryCodec<Value>::width));
+    BinaryCodec<uint64_t>::write(body, static_cast<uint64_t>(size_));
+
+    for (Node<Key, Value>* curr = getSmallestNode(); curr != NULL; curr = successor(curr)){
+        BinaryCodec<Key>::write(body, curr->getKey());
+        BinaryCodec<Value>::write(body, curr->getValue());
+    }
+    body.flush();
+    if (!body) throw std::runtime_error("BinarySearchTree::save: write failed");
+
+    // the checksum itself goes straight to out so it is not hashed
+    BinaryCodec<uint64_t>::write(out, checksum.digest());
+    if (!out) throw std::runtime_error("BinarySearchTree::save: write failed");
+}
+
+/**
+ * Replaces the contents of the tree with a snapshot written by save().
+ * The sorted records are linked into a vine as they stream in and then
+ * rebalanced once, so loading is O(n) with no per-record insert.
+ * Key and Value must be default constructible.
+ * Throws std::runtime_error on a bad header, unsorted keys, truncated data
+ * or a checksum mismatch; the tree is left unchanged in that case.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::load(std::istream& in)
+{
+    ChecksumStreamBuf checksum(in.rdbuf());
+    std::istream body(&checksum);
+
+    char magic[4];
+    uint32_t version = 0, keyWidth = 0, valueWidth = 0;
+    uint64_t count = 0;
+    body.read(magic, 4);
+    BinaryCodec<uint32_t>::read(body, version);
+    BinaryCodec<uint32_t>::read(body, keyWidth);
+    BinaryCodec<uint32_t>::read(body, valueWidth);
+    BinaryCodec<uint64_t>::read(body, count);
+    if (!body || std::string(magic, 4) != BST_SNAPSHOT_MAGIC){
+        throw std::runtime_error("BinarySearchTree::load: not a tree snapshot");
+    }
+    if (version != BST_SNAPSHOT_VERSION){
+        throw std::runtime_error("BinarySearchTree::load: unsupported snapshot version");
+    }
+    if (keyWidth != BinaryCodec<Key>::width || valueWidth != BinaryCodec<Value>::width){
+        throw std::runtime_error("BinarySearchTree::load: snapshot key/value types do not match");
+    }
+
+    // build the new nodes as a vine (right-linked sorted chain)
+    Node<Key, Value>* head = NULL;
+    Node<Key, Value>* tail = NULL;
+    try {
+        for (uint64_t i = 0; i < count; ++i){
+            Key key;
+            Value value;
+            BinaryCodec<Key>::read(body, key);
+            BinaryCodec<Value>::read(body, value);
+            if (!body){
+                throw std::runtime_error("BinarySearchTree::load: truncated snapshot");
+            }
+            if (tail != NULL && !(tail->getKey() < key)){
+                throw std::runtime_error("BinarySearchTree::load: keys are not in increasing order");
+            }
+            Node<Key, Value>* newnode = createNode(key, value, tail);
+            if (tail == NULL){
+                head = newnode;
+            }
+            else {
+                tail->setRight(newnode);
+            }
+            tail = newnode;
+        }
+        uint64_t stored = 0;
+        BinaryCodec<uint64_t>::read(in, stored);
+        if (!in || stored != checksum.digest()){
+            throw std::runtime_error("BinarySearchTree::load: checksum mismatch");
+        }
+    }
+    catch (...){
+        while (head != NULL){
+            Node<Key, Value>* next = head->getRight();
+            delete head;
+            head = next;
+        }
+        throw;
+    }
+
+    clear();
+    root_ = head;
+    size_ = static_cast<std::size_t>(count);
+    resetEnds();
+    rebalance();
+}
+
+/**
+ * Returns the hot-path counters. All zero unless built with -DBST_STATS.
+ */
+template<typename Key, typename Value>
+const TreeStats& BinarySearchTree<Key, Value>::stats() const
+{
+#ifdef BST_STATS
+    return stats_;
+#else
+    static const TreeStats none;
+    return none;
+#endif
+}
+
+/**
+ * Zeroes the hot-path counters.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::resetStats()
+{
+    BST_STAT(stats_.reset());
+}
+
+/**
+ * Writes the hot-path counters as text, or a note that they are disabled.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::printStats(std::ostream& out) const
+{
+#ifdef BST_STATS
+    stats_.print(out);
+#else
+    out << "statistics disabled (build with -DBST_STATS)\n";
+#endif
+}
+
+/**
+ * Measures the shape of the tree and the memory its nodes take, in one
+ * O(n) pre-order pass with an explicit stack.
+ */
+template<typename Key, typename Value>
+ShapeStats BinarySearchTree<Key, Value>::shape_stats() const
+{
+    ShapeStats shape;
+    shape.itemBytes = sizeof(std::pair<const Key, Value>);
+    shape.nodeBytes = nodeBytes();
+    shape.heapBytesPerNode = ShapeStats::heapChunk(shape.nodeBytes);
+
+    double depthSum = 0;
+    std::vector<std::pair<Node<Key, Value>*, int> > stack;
+    if (root_ != NULL) stack.push_back(std::make_pair(root_, 0));
+    while (!stack.empty()){
+        Node<Key, Value>* n = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
+        ++shape.nodes;
+        depthSum += depth;
+        if (shape.depthCounts.size() <= static_cast<std::size_t>(depth)){
+            shape.depthCounts.resize(depth + 1, 0);
+        }
+        ++shape.depthCounts[depth];
+        if (n->getLeft() == NULL && n->getRight() == NULL) ++shape.leaves;
+        if (n->getRight() != NULL) stack.push_back(std::make_pair(n->getRight(), depth + 1));
+        if (n->getLeft() != NULL) stack.push_back(std::make_pair(n->getLeft(), depth + 1));
+    }
+
+    shape.height = static_cast<int>(shape.depthCounts.size());
+    for (std::size_t full = 0; full < shape.nodes; full = 2*full + 1) ++shape.optimalHeight;
+    if (shape.nodes > 0) shape.averageDepth = depthSum / shape.nodes;
+    return shape;
+}
+
+/**
+ * A plain BST allocates plain Nodes
+ */
+template<typename Key, typename Value>
+std::size_t BinarySearchTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(Node<Key, Value>);
+}
+
 /**
  * Return true iff the BST is balanced.
+ * One O(n) pass, see validate().
  */
 template<typename Key, typename Value>
 bool BinarySearchTree<Key, Value>::isBalanced() const
 {
-    // TODO
-		// base case: when no root_
-		if (empty()) return true;
-		// base case 2: only root_ exists
-		else if (root_->getLeft() == NULL && root_->getRight() == NULL){
-			return true;
-		}
-		else {
-			return isBalancedHelp(root_);
-		}
+    return validate().heightBalanced();
 }
 
 
@@ -825,22 +1836,304 @@ int BinarySearchTree<Key, Value>::getHeight(Node<Key, Value>* curr_node) const
 
 
 /**
- * isBalanced() recursive helper
+ * Checks the whole tree in one O(n) pass: height balance, key ordering,
+ * parent pointers, the node count against size(), and the per-node
+ * invariant of the tree type (checkNode). The traversal uses an explicit
+ * stack, so degenerate trees cannot overflow the call stack.
+ * With parallel set, trees of at least BST_PARALLEL_VALIDATE_MIN nodes are
+ * split into subtrees that are validated concurrently with std::async.
  */
 template<typename Key, typename Value>
-bool BinarySearchTree<Key, Value>::isBalancedHelp(Node<Key, Value>* curr_node) const
+ValidationReport BinarySearchTree<Key, Value>::validate(bool parallel) const
 {
-    // if leaf node, return true
-    if (curr_node->getLeft() == nullptr && curr_node->getRight() == nullptr){
-        return true;
+    ValidationReport report;
+    if (root_ != NULL && root_->getParent() != NULL) ++report.parentViolations;
+
+    SubtreeSummary whole;
+    unsigned threads = std::thread::hardware_concurrency();
+    if (parallel && threads > 1 && size_ >= BST_PARALLEL_VALIDATE_MIN){
+        // about four subtrees per thread, so uneven subtrees still balance out
+        int splitDepth = 0;
+        while ((1u << splitDepth) < 4 * threads) ++splitDepth;
+        std::vector<Node<Key, Value>*> roots;
+        splitForValidation(root_, 0, splitDepth, roots);
+        std::vector<std::future<ValidatedPart> > parts;
+        for (std::size_t i = 0; i < roots.size(); ++i){
+            parts.push_back(std::async(std::launch::async, &BinarySearchTree<Key, Value>::validatePart, this, roots[i]));
+        }
+        std::size_t next = 0;
+        whole = validateTop(root_, 0, splitDepth, parts, next, report);
     }
-    // check if height of left subtree is within 1 of height of right sub tree
-    else if (std::abs(getHeight(curr_node->getLeft()) - getHeight(curr_node->getRight())) <= 1){
-        return isBalancedHelp(curr_node->getLeft()) && isBalancedHelp(curr_node->getRight());
+    else {
+        whole = validateSubtree(root_, report);
+    }
+    report.nodes = whole.count;
+    report.height = whole.height;
+    report.sizeMatches = (whole.count == size_);
+    report.endsMatch = (whole.min == min_ && whole.max == max_);
+    return report;
+}
+
+
+/**
+ * Per-node invariant hook for validate(). A plain BST has none.
+ */
+template<typename Key, typename Value>
+bool BinarySearchTree<Key, Value>::checkNode(const Node<Key, Value>* n, int leftHeight, int rightHeight) const
+{
+    return true;
+}
+
+
+/**
+ * validate() helper, checks n given the summaries of its two subtrees and
+ * returns the summary of the subtree rooted at n.
+ */
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::SubtreeSummary
+BinarySearchTree<Key, Value>::validateNode(Node<Key, Value>* n, const SubtreeSummary& left,
+                                           const SubtreeSummary& right, ValidationReport& report) const
+{
+    if (n->getLeft() != NULL && n->getLeft()->getParent() != n) ++report.parentViolations;
+    if (n->getRight() != NULL && n->getRight()->getParent() != n) ++report.parentViolations;
+    // the largest key on the left and the smallest on the right bound the whole subtrees
+    if ((left.max != NULL && !(left.max->getKey() < n->getKey())) ||
+        (right.min != NULL && !(n->getKey() < right.min->getKey()))){
+        ++report.orderViolations;
+    }
+    if (std::abs(left.height - right.height) > 1) ++report.unbalancedNodes;
+    if (!checkNode(n, left.height, right.height)) ++report.nodeViolations;
+
+    SubtreeSummary summary;
+    summary.min = (left.min != NULL) ? left.min : n;
+    summary.max = (right.max != NULL) ? right.max : n;
+    summary.height = std::max(left.height, right.height) + 1;
+    summary.count = left.count + right.count + 1;
+    return summary;
+}
+
+
+/**
+ * validate() helper, post-order traversal of sub with an explicit stack.
+ */
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::SubtreeSummary
+BinarySearchTree<Key, Value>::validateSubtree(Node<Key, Value>* sub, ValidationReport& report) const
+{
+    const SubtreeSummary none = { NULL, NULL, 0, 0 };
+    // (node, children done) pairs still to visit, and summaries of finished subtrees
+    std::vector<std::pair<Node<Key, Value>*, bool> > todo;
+    std::vector<SubtreeSummary> done;
+    todo.push_back(std::make_pair(sub, false));
+    while (!todo.empty()){
+        Node<Key, Value>* n = todo.back().first;
+        bool childrenDone = todo.back().second;
+        todo.pop_back();
+        if (n == NULL){
+            done.push_back(none);
+        }
+        else if (!childrenDone){
+            todo.push_back(std::make_pair(n, true));
+            todo.push_back(std::make_pair(n->getRight(), false));
+            todo.push_back(std::make_pair(n->getLeft(), false));
+        }
+        else {
+            // the left subtree finished first, so the right summary is on top
+            SubtreeSummary right = done.back();
+            done.pop_back();
+            SubtreeSummary left = done.back();
+            done.pop_back();
+            done.push_back(validateNode(n, left, right, report));
+        }
+    }
+    return done.back();
+}
+
+
+/**
+ * validate() helper, validates one subtree on its own (run on a worker thread).
+ */
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::ValidatedPart
+BinarySearchTree<Key, Value>::validatePart(Node<Key, Value>* sub) const
+{
+    ValidationReport report;
+    SubtreeSummary summary = validateSubtree(sub, report);
+    return std::make_pair(summary, report);
+}
+
+
+/**
+ * validate() helper, collects the subtrees at splitDepth (and any shallower
+ * missing children) left to right, in the order validateTop() visits them.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::splitForValidation(Node<Key, Value>* n, int depth, int splitDepth,
+                                                      std::vector<Node<Key, Value>*>& parts) const
+{
+    if (n == NULL || depth == splitDepth){
+        parts.push_back(n);
+        return;
+    }
+    splitForValidation(n->getLeft(), depth + 1, splitDepth, parts);
+    splitForValidation(n->getRight(), depth + 1, splitDepth, parts);
+}
+
+
+/**
+ * validate() helper, checks the nodes above splitDepth once the subtrees
+ * below them have been validated by the futures in parts.
+ */
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::SubtreeSummary
+BinarySearchTree<Key, Value>::validateTop(Node<Key, Value>* n, int depth, int splitDepth,
+                                          std::vector<std::future<ValidatedPart> >& parts,
+                                          std::size_t& next, ValidationReport& report) const
+{
+    if (n == NULL || depth == splitDepth){
+        ValidatedPart part = parts[next++].get();
+        report.addViolations(part.second);
+        return part.first;
+    }
+    SubtreeSummary left = validateTop(n->getLeft(), depth + 1, splitDepth, parts, next, report);
+    SubtreeSummary right = validateTop(n->getRight(), depth + 1, splitDepth, parts, next, report);
+    return validateNode(n, left, right, report);
+}
+
+
+/**
+ * Flattens the subtree rooted at sub into a "vine": a sorted chain of nodes
+ * linked through their right children, built with right rotations only.
+ * Returns the head (smallest node) of the vine and stores the number of
+ * nodes in count. The head's parent is left NULL for the caller to relink.
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::treeToVine(Node<Key, Value>* sub, std::size_t& count)
+{
+    Node<Key, Value>* head = NULL;
+    Node<Key, Value>* tail = NULL;
+    Node<Key, Value>* rest = sub;
+    count = 0;
+    while (rest != NULL){
+        Node<Key, Value>* left = rest->getLeft();
+        // rotate right until rest has no left child
+        if (left != NULL){
+            rest->setLeft(left->getRight());
+            if (left->getRight() != NULL){
+                left->getRight()->setParent(rest);
+            }
+            left->setRight(rest);
+            rest->setParent(left);
+            rest = left;
+        }
+        // otherwise rest is the next smallest node, append it to the vine
+        else {
+            if (tail == NULL){
+                head = rest;
+            }
+            else {
+                tail->setRight(rest);
+            }
+            rest->setParent(tail);
+            tail = rest;
+            rest = rest->getRight();
+            ++count;
+        }
+    }
+    return head;
+}
+
+/**
+ * One DSW compression pass: performs count left rotations on every
+ * other node down the vine's right spine. Returns the new head.
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::compressVine(Node<Key, Value>* head, std::size_t count)
+{
+    // last node of the already compressed part of the spine
+    Node<Key, Value>* scanner = NULL;
+    for (std::size_t i = 0; i < count; ++i){
+        Node<Key, Value>* child = (scanner == NULL) ? head : scanner->getRight();
+        Node<Key, Value>* next = child->getRight();
+
+        // rotate left at child
+        child->setRight(next->getLeft());
+        if (next->getLeft() != NULL){
+            next->getLeft()->setParent(child);
+        }
+        next->setLeft(child);
+        child->setParent(next);
+
+        if (scanner == NULL){
+            head = next;
+            next->setParent(NULL);
+        }
+        else {
+            scanner->setRight(next);
+            next->setParent(scanner);
+        }
+        scanner = next;
+    }
+    return head;
+}
+
+/**
+ * Turns a vine of count nodes (see treeToVine) into a tree of minimal
+ * height with every level full except possibly the last.
+ * Returns the new subtree root, whose parent is NULL.
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::vineToTree(Node<Key, Value>* head, std::size_t count)
+{
+    if (head == NULL) return NULL;
+    // largest full tree size (2^k - 1) that fits in count
+    std::size_t full = 1;
+    while (full <= count){
+        full = 2 * full + 1;
+    }
+    full /= 2;
+    // first place the leftover nodes on the bottom level
+    head = compressVine(head, count - full);
+    while (full > 1){
+        full /= 2;
+        head = compressVine(head, full);
+    }
+    head->setParent(NULL);
+    return head;
+}
+
+/**
+ * Rebuilds the subtree rooted at sub into a minimal height subtree in
+ * O(size) time and O(1) extra space, reusing the existing nodes.
+ * The rebuilt subtree is linked back in where sub used to be.
+ * Returns the root of the rebuilt subtree.
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::rebuildSubtree(Node<Key, Value>* sub)
+{
+    if (sub == NULL) return NULL;
+    Node<Key, Value>* parent = sub->getParent();
+    bool isLeft = (parent != NULL && parent->getLeft() == sub);
+
+    std::size_t count = 0;
+    Node<Key, Value>* head = treeToVine(sub, count);
+    Node<Key, Value>* newRoot = vineToTree(head, count);
+
+    newRoot->setParent(parent);
+    if (parent == NULL){
+        root_ = newRoot;
+    }
+    else if (isLeft){
+        parent->setLeft(newRoot);
     }
     else {
-        return false;
+        parent->setRight(newRoot);
     }
+    return newRoot;
 }
 
 
@@ -850,6 +2143,7 @@ void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value
     if((n1 == n2) || (n1 == NULL) || (n2 == NULL) ) {
         return;
     }
+    BST_STAT(++stats_.nodeSwaps);
     Node<Key, Value>* n1p = n1->getParent();
     Node<Key, Value>* n1r = n1->getRight();
     Node<Key, Value>* n1lt = n1->getLeft();
@@ -928,6 +2222,231 @@ void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value
 
 }
 
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::createNode(const Key& key, const Value& value, Node<Key, Value>* parent) const
+{
+    BST_STAT(++stats_.allocations);
+    return new Node<Key, Value>(key, value, parent);
+}
+
+/**
+* Node handle hook: a plain Node only. Subclass nodes would not do, their
+* getters cast the neighbouring nodes to their own type.
+*/
+template<typename Key, typename Value>
+bool BinarySearchTree<Key, Value>::canAdopt(const Node<Key, Value>* n) const
+{
+    return typeid(*n) == typeid(Node<Key, Value>);
+}
+
+/**
+* Node handle hook: n's stale links cleared and its parent set
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::adoptNode(Node<Key, Value>* n, Node<Key, Value>* parent) const
+{
+    n->setParent(parent);
+    n->setLeft(NULL);
+    n->setRight(NULL);
+    return n;
+}
+
+/**
+* findOrInsert() helper function
+* the node to link in below parent: detached if there is one, else a new one
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::makeNode(const Key& key, const Value& value,
+                                                         Node<Key, Value>* parent,
+                                                         Node<Key, Value>* detached) const
+{
+    if (detached != NULL) return adoptNode(detached, parent);
+    return createNode(key, value, parent);
+}
+
+/**
+ * Replaces the contents of this tree with a copy of other, node for node:
+ * the copy has the same shape and per-node data (an AVLTree's balances),
+ * so it needs no comparisons or rebalancing and costs O(n). With parallel
+ * set, trees of at least BST_PARALLEL_COPY_MIN nodes are split into
+ * subtrees that are copied concurrently with std::async.
+ * Throws std::invalid_argument if other's nodes lack data this tree's
+ * nodes need (e.g. copying a plain BinarySearchTree into an AVLTree).
+ * If an allocation fails, this tree is left unchanged.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::assign(const BinarySearchTree<Key, Value>& other, bool parallel)
+{
+    if (this == &other) return;
+    if (!canCloneFrom(other)){
+        throw std::invalid_argument("BinarySearchTree::assign: other is a different kind of tree");
+    }
+    unsigned threads = std::thread::hardware_concurrency();
+    Node<Key, Value>* copy;
+    if (parallel && threads > 1 && other.size_ >= BST_PARALLEL_COPY_MIN){
+        copy = cloneParallel(other.root_);
+    }
+    else {
+        copy = cloneSubtree(other.root_, NULL);
+    }
+    BST_STAT(stats_.allocations += other.size_);
+
+    clear();
+    root_ = copy;
+    size_ = other.size_;
+    resetEnds();
+    rebalanceFactor_ = other.rebalanceFactor_;
+}
+
+/**
+ * A plain BST's nodes only hold the item
+ */
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::cloneNode(const Node<Key, Value>* n, Node<Key, Value>* parent) const
+{
+    return new Node<Key, Value>(n->getKey(), n->getValue(), parent);
+}
+
+/**
+ * Any tree can be copied into a plain BST
+ */
+template<typename Key, typename Value>
+bool BinarySearchTree<Key, Value>::canCloneFrom(const BinarySearchTree<Key, Value>& other) const
+{
+    return true;
+}
+
+/**
+ * assign() helper, copies src's subtree in pre-order with an explicit
+ * stack and hangs the copy below parent. Frees the partial copy if an
+ * allocation throws.
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::cloneSubtree(const Node<Key, Value>* src, Node<Key, Value>* parent) const
+{
+    if (src == NULL) return NULL;
+    Node<Key, Value>* copy = cloneNode(src, parent);
+    // (source node, its copy) pairs whose children still need copying
+    std::vector<std::pair<const Node<Key, Value>*, Node<Key, Value>*> > stack;
+    try {
+        stack.push_back(std::make_pair(src, copy));
+        while (!stack.empty()){
+            const Node<Key, Value>* from = stack.back().first;
+            Node<Key, Value>* to = stack.back().second;
+            stack.pop_back();
+            if (from->getRight() != NULL){
+                to->setRight(cloneNode(from->getRight(), to));
+                stack.push_back(std::make_pair(from->getRight(), to->getRight()));
+            }
+            if (from->getLeft() != NULL){
+                to->setLeft(cloneNode(from->getLeft(), to));
+                stack.push_back(std::make_pair(from->getLeft(), to->getLeft()));
+            }
+        }
+    }
+    catch (...){
+        deleteSubtree(copy);
+        throw;
+    }
+    return copy;
+}
+
+/**
+ * assign() helper, copies the top levels of src itself and the subtrees
+ * below them concurrently, about four per hardware thread
+ */
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::cloneParallel(const Node<Key, Value>* src) const
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    int splitDepth = 0;
+    while ((1u << splitDepth) < 4 * threads) ++splitDepth;
+
+    // parts: (source subtree, copied parent) to fill in at splitDepth
+    std::vector<std::pair<const Node<Key, Value>*, Node<Key, Value>*> > parts;
+    Node<Key, Value>* copy = cloneTop(src, NULL, 0, splitDepth, parts);
+
+    std::vector<std::future<Node<Key, Value>*> > copies;
+    std::exception_ptr failure;
+    try {
+        for (std::size_t i = 0; i < parts.size(); ++i){
+            copies.push_back(std::async(std::launch::async, &BinarySearchTree<Key, Value>::cloneSubtree,
+                                        this, parts[i].first, parts[i].second));
+        }
+    }
+    catch (...){
+        failure = std::current_exception();
+    }
+    // collect every copy, even after a failure, so none is leaked
+    for (std::size_t i = 0; i < copies.size(); ++i){
+        try {
+            Node<Key, Value>* sub = copies[i].get();
+            const Node<Key, Value>* from = parts[i].first;
+            if (from->getParent()->getRight() == from) parts[i].second->setRight(sub);
+            else parts[i].second->setLeft(sub);
+        }
+        catch (...){
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure){
+        deleteSubtree(copy);
+        std::rethrow_exception(failure);
+    }
+    return copy;
+}
+
+/**
+ * assign() helper, copies the nodes of src above splitDepth and records
+ * the subtrees at splitDepth, with the copy of their parent, in parts
+ */
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::cloneTop(const Node<Key, Value>* src, Node<Key, Value>* parent, int depth, int splitDepth,
+                                       std::vector<std::pair<const Node<Key, Value>*, Node<Key, Value>*> >& parts) const
+{
+    Node<Key, Value>* copy = cloneNode(src, parent);
+    try {
+        const Node<Key, Value>* children[2] = { src->getLeft(), src->getRight() };
+        for (int i = 0; i < 2; ++i){
+            if (children[i] == NULL) continue;
+            if (depth + 1 == splitDepth){
+                parts.push_back(std::make_pair(children[i], copy));
+                continue;
+            }
+            Node<Key, Value>* child = cloneTop(children[i], copy, depth + 1, splitDepth, parts);
+            if (i == 0) copy->setLeft(child);
+            else copy->setRight(child);
+        }
+    }
+    catch (...){
+        deleteSubtree(copy);
+        throw;
+    }
+    return copy;
+}
+
+/**
+ * Frees the subtree sub, iteratively, and returns its number of nodes
+ */
+template<typename Key, typename Value>
+std::size_t BinarySearchTree<Key, Value>::deleteSubtree(Node<Key, Value>* sub)
+{
+    std::size_t count = 0;
+    std::vector<Node<Key, Value>*> stack;
+    if (sub != NULL) stack.push_back(sub);
+    while (!stack.empty()){
+        Node<Key, Value>* n = stack.back();
+        stack.pop_back();
+        if (n->getLeft() != NULL) stack.push_back(n->getLeft());
+        if (n->getRight() != NULL) stack.push_back(n->getRight());
+        delete n;
+        ++count;
+    }
+    return count;
+}
+
 /**
  * Lastly, we are providing you with a print function,
    BinarySearchTree::printRoot().
@@ -0,0 +1,183 @@
+#ifndef BST_CODEC_H
+#define BST_CODEC_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// Binary encoding used by BinarySearchTree::save() / load().
+//
+// Snapshot layout (all integers in native byte order):
+//   "BSTS"             4-byte magic
+//   uint32_t version   BST_SNAPSHOT_VERSION
+//   uint32_t keyWidth  BinaryCodec<Key>::width
+//   uint32_t valWidth  BinaryCodec<Value>::width
+//   uint64_t count     number of records
+//   count x (key, value) records, in increasing key order
+//   uint64_t checksum  FNV-1a of every byte above
+#define BST_SNAPSHOT_MAGIC "BSTS"
+#define BST_SNAPSHOT_VERSION 1
+
+// largest piece of a string BinaryCodec reads (and allocates) at once
+#define BST_CODEC_STRING_CHUNK 65536
+
+/**
+ * Encodes one key or value of type T in a snapshot.
+ *
+ * The default handles trivially copyable types by writing their bytes raw,
+ * in native byte order. For any other type, provide a full specialization
+ * with the same three members, e.g. see BinaryCodec<std::string> below.
+ *
+ * width is the fixed encoded size in bytes, or 0 for variable length.
+ * It is stored in the snapshot header so a load into a differently sized
+ * type is rejected instead of misread.
+ */
+template<typename T>
+struct BinaryCodec
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+        "BinaryCodec: specialize BinaryCodec<T> for types that are not trivially copyable");
+
+    static const uint32_t width = sizeof(T);
+
+    static void write(std::ostream& out, const T& item)
+    {
+        out.write(reinterpret_cast<const char*>(&item), sizeof(T));
+    }
+
+    static void read(std::istream& in, T& item)
+    {
+        in.read(reinterpret_cast<char*>(&item), sizeof(T));
+    }
+};
+
+/**
+ * Strings are written as a uint64_t length followed by the characters.
+ */
+template<>
+struct BinaryCodec<std::string>
+{
+    static const uint32_t width = 0;
+
+    static void write(std::ostream& out, const std::string& item)
+    {
+        uint64_t length = item.size();
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(item.data(), static_cast<std::streamsize>(item.size()));
+    }
+
+    // The length is not trusted before load() checks the checksum, so the
+    // characters are read in chunks of at most BST_CODEC_STRING_CHUNK bytes:
+    // a corrupt length runs into the end of the stream (and load() reports
+    // a truncated snapshot) instead of allocating it all up front.
+    static void read(std::istream& in, std::string& item)
+    {
+        uint64_t length = 0;
+        in.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!in) return;
+        item.clear();
+        while (length > 0){
+            std::size_t part = length < BST_CODEC_STRING_CHUNK ?
+                static_cast<std::size_t>(length) : BST_CODEC_STRING_CHUNK;
+            std::size_t done = item.size();
+            item.resize(done + part);
+            in.read(&item[done], static_cast<std::streamsize>(part));
+            if (!in){
+                item.resize(done + static_cast<std::size_t>(in.gcount()));
+                return;
+            }
+            length -= part;
+        }
+    }
+};
+
+/**
+ * 64-bit FNV-1a running hash, used as the snapshot checksum.
+ */
+class Fnv1a64
+{
+public:
+    Fnv1a64() : hash_(14695981039346656037ULL) { }
+
+    void update(const char* data, std::size_t length)
+    {
+        for (std::size_t i = 0; i < length; ++i){
+            hash_ ^= static_cast<unsigned char>(data[i]);
+            hash_ *= 1099511628211ULL;
+        }
+    }
+
+    uint64_t digest() const { return hash_; }
+
+private:
+    uint64_t hash_;
+};
+
+/**
+ * Unbuffered stream buffer that forwards to another stream buffer and
+ * hashes every byte that passes through it. Because nothing is read ahead,
+ * the underlying stream is left positioned right after the last byte
+ * consumed, so trailing data (the checksum) can be read from it directly.
+ */
+class ChecksumStreamBuf : public std::streambuf
+{
+public:
+    explicit ChecksumStreamBuf(std::streambuf* target) : target_(target) { }
+
+    uint64_t digest() const { return hash_.digest(); }
+
+protected:
+    // output side
+    virtual int_type overflow(int_type ch)
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        if (traits_type::eq_int_type(target_->sputc(c), traits_type::eof())) return traits_type::eof();
+        hash_.update(&c, 1);
+        return ch;
+    }
+
+    virtual std::streamsize xsputn(const char* s, std::streamsize n)
+    {
+        std::streamsize written = target_->sputn(s, n);
+        hash_.update(s, static_cast<std::size_t>(written));
+        return written;
+    }
+
+    virtual int sync()
+    {
+        return target_->pubsync();
+    }
+
+    // input side: peek without hashing, hash only what gets consumed
+    virtual int_type underflow()
+    {
+        return target_->sgetc();
+    }
+
+    virtual int_type uflow()
+    {
+        int_type ch = target_->sbumpc();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())){
+            char c = traits_type::to_char_type(ch);
+            hash_.update(&c, 1);
+        }
+        return ch;
+    }
+
+    virtual std::streamsize xsgetn(char* s, std::streamsize n)
+    {
+        std::streamsize got = target_->sgetn(s, n);
+        hash_.update(s, static_cast<std::size_t>(got));
+        return got;
+    }
+
+private:
+    std::streambuf* target_;
+    Fnv1a64 hash_;
+};
+
+#endif
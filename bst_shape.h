@@ -0,0 +1,72 @@
+#ifndef BST_SHAPE_H
+#define BST_SHAPE_H
+
+#include <iostream>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Result of BinarySearchTree::shape_stats(): the shape of the tree and
+ * what its nodes cost in memory, from a single pass over it.
+ */
+struct ShapeStats
+{
+    std::size_t nodes;
+    std::size_t leaves;
+    int height;                         // levels, 0 for an empty tree
+    int optimalHeight;                  // levels of a complete tree with as many nodes
+    double averageDepth;                // root at depth 0
+    std::vector<std::size_t> depthCounts;   // depthCounts[d]: nodes at depth d
+
+    std::size_t itemBytes;              // sizeof(std::pair<const Key, Value>)
+    std::size_t nodeBytes;              // sizeof the tree's node type: item, vptr, links, balance, padding
+    std::size_t heapBytesPerNode;       // nodeBytes as a malloc chunk (estimate, see below)
+
+    ShapeStats() :
+        nodes(0), leaves(0), height(0), optimalHeight(0), averageDepth(0.0),
+        itemBytes(0), nodeBytes(0), heapBytesPerNode(0)
+    {
+
+    }
+
+    int maxDepth() const { return height - 1; }   // -1 for an empty tree
+
+    // height relative to the best possible, 1.0 for a complete tree
+    double heightRatio() const
+    {
+        return optimalHeight ? static_cast<double>(height) / optimalHeight : 1.0;
+    }
+
+    // heap memory held by the nodes
+    std::size_t bytes() const { return nodes * heapBytesPerNode; }
+
+    // the part of bytes() that is not keys and values
+    std::size_t overheadBytes() const { return bytes() - nodes * itemBytes; }
+
+    /**
+     * Size of the heap chunk behind an allocation of size bytes, for a
+     * glibc-style allocator: one size_t of header, rounded up to two
+     * size_t and at least four of them.
+     */
+    static std::size_t heapChunk(std::size_t size)
+    {
+        const std::size_t word = sizeof(std::size_t);
+        std::size_t chunk = (size + word + 2*word - 1) / (2*word) * (2*word);
+        return chunk < 4*word ? 4*word : chunk;
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << "nodes: " << nodes << "\n"
+            << "leaves: " << leaves << "\n"
+            << "height: " << height << " (optimal " << optimalHeight << ", ratio " << heightRatio() << ")\n"
+            << "depth (average/max): " << averageDepth << "/" << maxDepth() << "\n"
+            << "nodes per depth:";
+        for (std::size_t d = 0; d < depthCounts.size(); ++d) out << " " << depthCounts[d];
+        out << "\n"
+            << "bytes per node (item/node/heap chunk): " << itemBytes << "/" << nodeBytes << "/" << heapBytesPerNode << "\n"
+            << "bytes: " << bytes() << " (" << overheadBytes() << " overhead)\n";
+    }
+};
+
+#endif
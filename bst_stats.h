@@ -0,0 +1,82 @@
+#ifndef BST_STATS_H
+#define BST_STATS_H
+
+#include <iostream>
+#include <cstdint>
+
+// Hot-path statistics for BinarySearchTree and its subclasses.
+//
+// Counting is opt-in at compile time: build with -DBST_STATS (see DEFS in
+// the Makefile) and every tree gets a TreeStats member that the search,
+// insert, remove and rebalancing code updates. Without it BST_STAT(...)
+// expands to nothing, trees carry no extra member and stats() returns an
+// all-zero TreeStats, so instrumented code costs nothing when disabled.
+#ifdef BST_STATS
+#define BST_STAT(expr) (expr)
+#else
+#define BST_STAT(expr) ((void)0)
+#endif
+
+/**
+ * Counters collected when BST_STATS is defined.
+ */
+struct TreeStats
+{
+    // public operations
+    uint64_t finds;
+    uint64_t inserts;
+    uint64_t removes;
+
+    // work done by the descents (internalFind, locate, ...)
+    uint64_t comparisons;
+    uint64_t nodesVisited;
+
+    // rebalancing
+    uint64_t rotateLefts;
+    uint64_t rotateRights;
+    uint64_t insertFixCalls;      // insertFix calls, including recursive ones
+    uint64_t removeFixCalls;      // removeFix calls, including recursive ones
+    uint64_t maxInsertFixDepth;   // longest insertFix chain in one insert
+    uint64_t maxRemoveFixDepth;   // longest removeFix chain in one remove
+    uint64_t fixDepth;            // length of the chain in progress
+
+    uint64_t nodeSwaps;
+    uint64_t allocations;
+
+    TreeStats() { reset(); }
+
+    void reset()
+    {
+        finds = inserts = removes = 0;
+        comparisons = nodesVisited = 0;
+        rotateLefts = rotateRights = 0;
+        insertFixCalls = removeFixCalls = 0;
+        maxInsertFixDepth = maxRemoveFixDepth = fixDepth = 0;
+        nodeSwaps = allocations = 0;
+    }
+
+    /**
+     * Writes the counters, one "name: value" per line, followed by
+     * per-operation averages.
+     */
+    void print(std::ostream& out) const
+    {
+        uint64_t ops = finds + inserts + removes;
+        out << "finds: " << finds << "\n"
+            << "inserts: " << inserts << "\n"
+            << "removes: " << removes << "\n"
+            << "comparisons: " << comparisons << "\n"
+            << "nodes visited: " << nodesVisited << "\n"
+            << "rotations (left/right): " << rotateLefts << "/" << rotateRights << "\n"
+            << "insertFix calls (max depth): " << insertFixCalls << " (" << maxInsertFixDepth << ")\n"
+            << "removeFix calls (max depth): " << removeFixCalls << " (" << maxRemoveFixDepth << ")\n"
+            << "node swaps: " << nodeSwaps << "\n"
+            << "node allocations: " << allocations << "\n";
+        if (ops > 0){
+            out << "comparisons per op: " << static_cast<double>(comparisons) / ops << "\n"
+                << "nodes visited per op: " << static_cast<double>(nodesVisited) / ops << "\n";
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef BST_VALIDATE_H
+#define BST_VALIDATE_H
+
+#include <iostream>
+#include <cstddef>
+
+// validate(true) only splits trees at least this large across threads
+#define BST_PARALLEL_VALIDATE_MIN 65536
+
+/**
+ * Result of BinarySearchTree::validate(): what a single pass over the
+ * tree found. Counters are numbers of offending nodes, so a healthy tree
+ * reports zeros everywhere.
+ */
+struct ValidationReport
+{
+    std::size_t nodes;              // nodes reachable from the root
+    int height;                     // levels, 0 for an empty tree
+    std::size_t unbalancedNodes;    // children's heights differ by more than one
+    std::size_t orderViolations;    // key not greater than its left subtree / less than its right
+    std::size_t parentViolations;   // parent pointer does not point back (root: is not NULL)
+    std::size_t nodeViolations;     // per-node invariant of the tree type (AVL: balance_)
+    bool sizeMatches;               // nodes == size()
+    bool endsMatch;                 // min()/max() are the smallest/largest nodes
+
+    ValidationReport() :
+        nodes(0), height(0), unbalancedNodes(0), orderViolations(0),
+        parentViolations(0), nodeViolations(0), sizeMatches(true), endsMatch(true)
+    {
+
+    }
+
+    bool heightBalanced() const { return unbalancedNodes == 0; }
+    bool ordered() const { return orderViolations == 0; }
+    bool parentsConsistent() const { return parentViolations == 0; }
+    bool nodesConsistent() const { return nodeViolations == 0; }
+
+    /**
+     * True iff the structure is a correct tree of its type. Height balance
+     * is not part of this for a plain BinarySearchTree; balanced trees
+     * report it through their per-node check.
+     */
+    bool valid() const
+    {
+        return ordered() && parentsConsistent() && nodesConsistent() && sizeMatches && endsMatch;
+    }
+
+    // adds the violation counters of a separately validated part of the tree
+    void addViolations(const ValidationReport& other)
+    {
+        unbalancedNodes += other.unbalancedNodes;
+        orderViolations += other.orderViolations;
+        parentViolations += other.parentViolations;
+        nodeViolations += other.nodeViolations;
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << "nodes: " << nodes << (sizeMatches ? "" : " (does not match size())") << "\n"
+            << "height: " << height << "\n"
+            << "unbalanced nodes: " << unbalancedNodes << "\n"
+            << "order violations: " << orderViolations << "\n"
+            << "parent violations: " << parentViolations << "\n"
+            << "node invariant violations: " << nodeViolations << "\n"
+            << (endsMatch ? "" : "cached min/max are stale\n")
+            << (valid() ? "valid" : "INVALID") << "\n";
+    }
+};
+
+#endif
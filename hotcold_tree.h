@@ -0,0 +1,492 @@
+#ifndef HOTCOLD_TREE_H
+#define HOTCOLD_TREE_H
+
+#include <iostream>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "avlbst.h"
+
+// Hot/cold split layout for large values.
+//
+// An AVLTree<Key, Value> node holds the whole item, so with values of a
+// few hundred bytes each node spans several cache lines and a lookup drags
+// value bytes it never reads through the cache at every level.
+// HotColdAVLTree keeps the key, the links and a pointer to the value in a
+// small "hot" AVLNode and stores the values themselves "cold", packed into
+// the chunks of a ValueArena. A descent touches only hot nodes; the value
+// is read once, at the end.
+
+// bytes per ValueArena chunk (at least one value per chunk)
+#define VALUE_ARENA_CHUNK_BYTES 65536
+
+/**
+ * Chunked storage for values of one type: values are placed in large
+ * chunks, freed slots are reused before the arena grows, and the chunks
+ * are only returned to the heap by clear(). Not copyable.
+ */
+template <typename Value>
+class ValueArena
+{
+public:
+    ValueArena();
+    ~ValueArena();
+
+    Value* create(const Value& value);
+    void destroy(Value* value);
+    void clear();
+    std::size_t chunks() const;
+
+private:
+    ValueArena(const ValueArena<Value>&);
+    ValueArena<Value>& operator=(const ValueArena<Value>&);
+
+    // a value, or the next free slot while unused
+    union Slot
+    {
+        Slot* next;
+        typename std::aligned_storage<sizeof(Value), std::alignment_of<Value>::value>::type storage;
+    };
+    static const std::size_t SLOTS_PER_CHUNK =
+        sizeof(Slot) < VALUE_ARENA_CHUNK_BYTES ? VALUE_ARENA_CHUNK_BYTES / sizeof(Slot) : 1;
+
+    std::vector<Slot*> chunks_;
+    // freed slots, reused first
+    Slot* free_;
+    // slots handed out from the newest chunk
+    std::size_t used_;
+};
+
+template<typename Value>
+ValueArena<Value>::ValueArena() :
+    free_(NULL), used_(SLOTS_PER_CHUNK)
+{
+
+}
+
+/**
+ * Returns the chunks to the heap. Values still in the arena are not
+ * destroyed; the owner destroys them first.
+ */
+template<typename Value>
+ValueArena<Value>::~ValueArena()
+{
+    clear();
+}
+
+/**
+ * Copies value into a free slot and returns it
+ */
+template<typename Value>
+Value* ValueArena<Value>::create(const Value& value)
+{
+    Slot* slot;
+    if (free_ != NULL){
+        slot = free_;
+        free_ = free_->next;
+    }
+    else {
+        if (used_ == SLOTS_PER_CHUNK){
+            Slot* chunk = new Slot[SLOTS_PER_CHUNK];
+            try {
+                chunks_.push_back(chunk);
+            }
+            catch (...){
+                delete [] chunk;
+                throw;
+            }
+            used_ = 0;
+        }
+        slot = &chunks_.back()[used_++];
+    }
+    try {
+        return new (&slot->storage) Value(value);
+    }
+    catch (...){
+        slot->next = free_;
+        free_ = slot;
+        throw;
+    }
+}
+
+/**
+ * Destroys a value made by create() and frees its slot
+ */
+template<typename Value>
+void ValueArena<Value>::destroy(Value* value)
+{
+    value->~Value();
+    Slot* slot = reinterpret_cast<Slot*>(value);
+    slot->next = free_;
+    free_ = slot;
+}
+
+/**
+ * Returns every chunk to the heap. All values must have been destroyed.
+ */
+template<typename Value>
+void ValueArena<Value>::clear()
+{
+    for (std::size_t i = 0; i < chunks_.size(); ++i){
+        delete [] chunks_[i];
+    }
+    chunks_.clear();
+    free_ = NULL;
+    used_ = SLOTS_PER_CHUNK;
+}
+
+template<typename Value>
+std::size_t ValueArena<Value>::chunks() const
+{
+    return chunks_.size();
+}
+
+
+/**
+* An AVL tree map with the hot/cold layout described above. It offers the
+* AVLTree interface, and its iterators and operator[] behave the same:
+* it->first and it->second name the key and the stored value, (*it) is a
+* pair of references to them, and operator[] returns the value, inserting
+* Value() for a missing key (the const one throws std::out_of_range).
+* Only the pair itself is not stored anywhere, so taking its address is
+* not supported.
+*/
+template <typename Key, typename Value>
+class HotColdAVLTree
+{
+public:
+    typedef AVLTree<Key, Value*> index_type;
+
+    class iterator
+    {
+    public:
+        typedef std::pair<const Key&, Value&> reference;
+        // what operator-> returns: holds the pair of references
+        struct pointer
+        {
+            reference item;
+            const reference* operator->() const { return &item; }
+        };
+
+        iterator();
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class HotColdAVLTree<Key, Value>;
+        iterator(const typename index_type::iterator& it);
+        typename index_type::iterator it_;
+    };
+
+    HotColdAVLTree();
+    HotColdAVLTree(const HotColdAVLTree<Key, Value>& other);
+    HotColdAVLTree<Key, Value>& operator=(const HotColdAVLTree<Key, Value>& other);
+    ~HotColdAVLTree();
+
+    std::pair<iterator, bool> insert(const std::pair<const Key, Value>& new_item);
+    void remove(const Key& key);
+    iterator erase(iterator pos);
+    void clear();
+    bool empty() const;
+    std::size_t size() const;
+    int height() const;
+    bool isBalanced() const;
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator find(const Key& key, iterator hint) const;
+    void find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    // hot part: keys, links and value pointers
+    index_type index_;
+    // cold part: the values
+    ValueArena<Value> values_;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the HotColdAVLTree::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>::iterator::iterator() :
+    it_()
+{
+
+}
+
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>::iterator::iterator(const typename index_type::iterator& it) :
+    it_(it)
+{
+
+}
+
+/**
+* The key and value, as a pair of references
+*/
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator::reference
+HotColdAVLTree<Key, Value>::iterator::operator*() const
+{
+    return reference(it_->first, *it_->second);
+}
+
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator::pointer
+HotColdAVLTree<Key, Value>::iterator::operator->() const
+{
+    pointer p = { **this };
+    return p;
+}
+
+/**
+* Same position: each value has its own slot, so comparing the stored
+* pointers compares values by identity
+*/
+template<class Key, class Value>
+bool HotColdAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return it_ == rhs.it_;
+}
+
+template<class Key, class Value>
+bool HotColdAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return it_ != rhs.it_;
+}
+
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator&
+HotColdAVLTree<Key, Value>::iterator::operator++()
+{
+    ++it_;
+    return *this;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the HotColdAVLTree::iterator class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>::HotColdAVLTree()
+{
+
+}
+
+/**
+* Copies other's index node for node (see BinarySearchTree::assign()),
+* then gives each copied node its own copy of the value.
+*/
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>::HotColdAVLTree(const HotColdAVLTree<Key, Value>& other)
+{
+    *this = other;
+}
+
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>& HotColdAVLTree<Key, Value>::operator=(const HotColdAVLTree<Key, Value>& other)
+{
+    if (this == &other) return *this;
+    clear();
+    index_ = other.index_;
+    typename index_type::iterator it = index_.begin();
+    try {
+        for (; it != index_.end(); ++it){
+            it->second = values_.create(*it->second);
+        }
+    }
+    catch (...){
+        // the values from it on still point into other
+        for (typename index_type::iterator done = index_.begin(); done != it; ++done){
+            values_.destroy(done->second);
+        }
+        index_.clear();
+        values_.clear();
+        throw;
+    }
+    return *this;
+}
+
+template<class Key, class Value>
+HotColdAVLTree<Key, Value>::~HotColdAVLTree()
+{
+    clear();
+}
+
+/**
+* Inserts the pair, or overwrites the value if the key is already there,
+* and returns the key's position and whether it was new.
+* One descent: a new key gets its index node (with a NULL value pointer)
+* first, then its value.
+*/
+template<class Key, class Value>
+std::pair<typename HotColdAVLTree<Key, Value>::iterator, bool>
+HotColdAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& new_item)
+{
+    std::pair<typename index_type::iterator, bool> slot =
+        index_.try_insert(std::make_pair(new_item.first, static_cast<Value*>(NULL)));
+    if (!slot.second){
+        *slot.first->second = new_item.second;
+    }
+    else {
+        try {
+            slot.first->second = values_.create(new_item.second);
+        }
+        catch (...){
+            index_.erase(slot.first);
+            throw;
+        }
+    }
+    return std::make_pair(iterator(slot.first), slot.second);
+}
+
+/**
+* One descent: the node found is erased through its iterator
+*/
+template<class Key, class Value>
+void HotColdAVLTree<Key, Value>::remove(const Key& key)
+{
+    typename index_type::iterator it = index_.find(key);
+    if (it == index_.end()) return;
+    Value* value = it->second;
+    index_.erase(it);
+    values_.destroy(value);
+}
+
+/**
+* Removes the item at pos and returns the one after it, see
+* BinarySearchTree::erase(iterator)
+*/
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator HotColdAVLTree<Key, Value>::erase(iterator pos)
+{
+    if (pos == end()) return end();
+    Value* value = pos.it_->second;
+    typename index_type::iterator next = index_.erase(pos.it_);
+    values_.destroy(value);
+    return iterator(next);
+}
+
+/**
+* Removes everything and returns the value chunks to the heap
+*/
+template<class Key, class Value>
+void HotColdAVLTree<Key, Value>::clear()
+{
+    for (typename index_type::iterator it = index_.begin(); it != index_.end(); ++it){
+        values_.destroy(it->second);
+    }
+    index_.clear();
+    values_.clear();
+}
+
+template<class Key, class Value>
+bool HotColdAVLTree<Key, Value>::empty() const
+{
+    return index_.empty();
+}
+
+template<class Key, class Value>
+std::size_t HotColdAVLTree<Key, Value>::size() const
+{
+    return index_.size();
+}
+
+template<class Key, class Value>
+int HotColdAVLTree<Key, Value>::height() const
+{
+    return index_.height();
+}
+
+template<class Key, class Value>
+bool HotColdAVLTree<Key, Value>::isBalanced() const
+{
+    return index_.isBalanced();
+}
+
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator HotColdAVLTree<Key, Value>::begin() const
+{
+    return iterator(index_.begin());
+}
+
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator HotColdAVLTree<Key, Value>::end() const
+{
+    return iterator(index_.end());
+}
+
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator HotColdAVLTree<Key, Value>::find(const Key& key) const
+{
+    return iterator(index_.find(key));
+}
+
+/**
+* Finger search, see BinarySearchTree::find(key, hint)
+*/
+template<class Key, class Value>
+typename HotColdAVLTree<Key, Value>::iterator HotColdAVLTree<Key, Value>::find(const Key& key, iterator hint) const
+{
+    return iterator(index_.find(key, hint.it_));
+}
+
+/**
+* Batched lookup, see BinarySearchTree::find_batch()
+*/
+template<class Key, class Value>
+void HotColdAVLTree<Key, Value>::find_batch(const std::vector<Key>& keys, std::vector<iterator>& out) const
+{
+    std::vector<typename index_type::iterator> found;
+    index_.find_batch(keys, found);
+    out.resize(found.size());
+    for (std::size_t i = 0; i < found.size(); ++i){
+        out[i] = iterator(found[i]);
+    }
+}
+
+/**
+* Returns key's value, inserting Value() first if the key is missing
+*/
+template<class Key, class Value>
+Value& HotColdAVLTree<Key, Value>::operator[](const Key& key)
+{
+    Value*& value = index_[key];
+    if (value == NULL){
+        try {
+            value = values_.create(Value());
+        }
+        catch (...){
+            index_.remove(key);
+            throw;
+        }
+    }
+    return *value;
+}
+
+template<class Key, class Value>
+Value const & HotColdAVLTree<Key, Value>::operator[](const Key& key) const
+{
+    typename index_type::iterator it = index_.find(key);
+    if (it == index_.end()) throw std::out_of_range("Invalid key");
+    return *it->second;
+}
+
+#endif
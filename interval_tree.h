@@ -0,0 +1,170 @@
+#ifndef INTERVAL_TREE_H
+#define INTERVAL_TREE_H
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <limits>
+#include "aggregate_tree.h"
+
+/**
+ * A closed interval [low, high], the key type of IntervalTree. Ordered by
+ * low, then high.
+ */
+template <typename T>
+struct Interval
+{
+    T low;
+    T high;
+
+    Interval() : low(), high() { }
+    Interval(const T& l, const T& h) : low(l), high(h) { }
+
+    bool operator<(const Interval<T>& rhs) const
+    {
+        return low < rhs.low || (!(rhs.low < low) && high < rhs.high);
+    }
+    bool operator>(const Interval<T>& rhs) const { return rhs < *this; }
+    bool operator<=(const Interval<T>& rhs) const { return !(rhs < *this); }
+    bool operator>=(const Interval<T>& rhs) const { return !(*this < rhs); }
+    bool operator==(const Interval<T>& rhs) const { return low == rhs.low && high == rhs.high; }
+    bool operator!=(const Interval<T>& rhs) const { return !(*this == rhs); }
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const Interval<T>& interval)
+{
+    return out << '[' << interval.low << ", " << interval.high << ']';
+}
+
+/**
+ * Monoid for IntervalTree: the largest interval end in a subtree,
+ * numeric_limits<T>::lowest() for an empty one.
+ */
+template <typename T, typename Value>
+struct IntervalEndMonoid
+{
+    typedef T type;
+    static type identity() { return std::numeric_limits<T>::lowest(); }
+    static type of(const Interval<T>& key, const Value&) { return key.high; }
+    static type combine(const type& a, const type& b) { return (a < b) ? b : a; }
+};
+
+/**
+* A set of closed intervals [low, high], each with a value, that finds
+* every interval containing a point or overlapping a range without
+* scanning.
+*
+* The intervals are the keys of an AggregateAVLTree, ordered by low and
+* then high, and every node stores the largest high in its subtree. A
+* query skips any subtree whose largest high is below the query range, and
+* everything right of a node whose low is above it, so it only walks the
+* paths down to the k intervals it reports: O((k + 1) log n) at worst and
+* close to O(log n + k) when they are near each other in key order.
+* An interval that is inserted twice keeps the latest value.
+*/
+template <typename T, typename Value>
+class IntervalTree : public AggregateAVLTree<Interval<T>, Value, IntervalEndMonoid<T, Value> >
+{
+public:
+    typedef Interval<T> interval_type;
+    typedef typename AggregateAVLTree<interval_type, Value, IntervalEndMonoid<T, Value> >::iterator iterator;
+
+    IntervalTree();
+    IntervalTree(const IntervalTree<T, Value>& other);
+    std::pair<iterator, bool> insert(const T& low, const T& high, const Value& value);
+    using AggregateAVLTree<interval_type, Value, IntervalEndMonoid<T, Value> >::insert;
+    void remove(const T& low, const T& high);
+    using AggregateAVLTree<interval_type, Value, IntervalEndMonoid<T, Value> >::remove;
+
+    void stab(const T& point, std::vector<iterator>& out) const;
+    void overlap(const T& low, const T& high, std::vector<iterator>& out) const;
+
+protected:
+    typedef AggregateNode<interval_type, Value, IntervalEndMonoid<T, Value> > INode;
+
+    // Add helper functions here
+    void overlapHelp(INode* n, const T& low, const T& high, std::vector<iterator>& out) const;
+};
+
+template<class T, class Value>
+IntervalTree<T, Value>::IntervalTree() :
+    AggregateAVLTree<interval_type, Value, IntervalEndMonoid<T, Value> >()
+{
+
+}
+
+/*
+ * Copies other node for node (see AVLTree's copy constructor)
+ */
+template<class T, class Value>
+IntervalTree<T, Value>::IntervalTree(const IntervalTree<T, Value>& other) :
+    AggregateAVLTree<interval_type, Value, IntervalEndMonoid<T, Value> >()
+{
+    this->assign(other);
+}
+
+/*
+ * Adds the interval [low, high] with the given value, or replaces the
+ * value if it is already there. Throws std::invalid_argument if
+ * high < low. Returns what BinarySearchTree::insert() does.
+ */
+template<class T, class Value>
+std::pair<typename IntervalTree<T, Value>::iterator, bool>
+IntervalTree<T, Value>::insert(const T& low, const T& high, const Value& value)
+{
+    if (high < low) throw std::invalid_argument("IntervalTree::insert: high < low");
+    return this->insert(std::make_pair(interval_type(low, high), value));
+}
+
+/*
+ * Removes the interval [low, high], if present
+ */
+template<class T, class Value>
+void IntervalTree<T, Value>::remove(const T& low, const T& high)
+{
+    this->remove(interval_type(low, high));
+}
+
+/*
+ * Replaces out with the intervals that contain point, in key order
+ */
+template<class T, class Value>
+void IntervalTree<T, Value>::stab(const T& point, std::vector<iterator>& out) const
+{
+    overlap(point, point, out);
+}
+
+/*
+ * Replaces out with the intervals that share at least one point with
+ * [low, high], in key order
+ */
+template<class T, class Value>
+void IntervalTree<T, Value>::overlap(const T& low, const T& high, std::vector<iterator>& out) const
+{
+    out.clear();
+    if (high < low) return;
+    overlapHelp(static_cast<INode*>(this->root_), low, high, out);
+}
+
+/*
+ * overlap() helper function
+ * in-order walk of n's subtree that skips subtrees which cannot overlap
+ */
+template<class T, class Value>
+void IntervalTree<T, Value>::overlapHelp(INode* n, const T& low, const T& high, std::vector<iterator>& out) const
+{
+    // nothing in this subtree ends at or after low
+    if (!n || n->getAggregate() < low) return;
+    BST_STAT((++this->stats_.nodesVisited, this->stats_.comparisons += 2));
+    overlapHelp(n->getLeft(), low, high, out);
+    // n and everything right of it start after high
+    if (high < n->getKey().low) return;
+    if (!(n->getKey().high < low)){
+        out.push_back(this->iteratorAt(n));
+    }
+    overlapHelp(n->getRight(), low, high, out);
+}
+
+#endif
@@ -0,0 +1,485 @@
+#ifndef MAPPED_TREE_H
+#define MAPPED_TREE_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <type_traits>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bst.h"
+
+// Read-only tree file served straight from mmap().
+//
+// File layout (native byte order), written by MappedTree::write():
+//   MappedTreeHeader   64 bytes
+//   count x MappedRecord<Key, Value>, in increasing key order
+//
+// Records keep the shape of the tree they were written from: left/right
+// are indexes into the record array (MAPPED_TREE_NIL for no child) rather
+// than pointers, so the file is position independent and can be mapped at
+// any address, by any number of processes sharing the same page cache.
+// Lookups check every link they follow, so a corrupt file makes them throw
+// std::runtime_error instead of reading out of bounds or looping.
+#define MAPPED_TREE_MAGIC "BSTMAP\0"
+#define MAPPED_TREE_VERSION 1
+#define MAPPED_TREE_NIL UINT64_MAX
+
+struct MappedTreeHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t root;
+    uint64_t reserved[3];
+};
+
+/**
+ * One node of a mapped tree. The first/second names mirror std::pair so
+ * iterators read the same as BinarySearchTree iterators (it->first).
+ */
+template <typename Key, typename Value>
+struct MappedRecord
+{
+    Key first;
+    Value second;
+    uint64_t left;
+    uint64_t right;
+};
+
+/**
+ * A read-only, memory-mapped view of a tree written by MappedTree::write().
+ * Opening a file only maps and validates the header, so it takes the same
+ * time regardless of the file size; pages are faulted in as lookups touch
+ * them. find() and lower_bound() walk the stored tree shape and iteration
+ * is a linear scan of the sorted records.
+ * Key and Value must be trivially copyable.
+ */
+template <typename Key, typename Value>
+class MappedTree
+{
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+        "MappedTree: Key and Value must be trivially copyable");
+
+public:
+    typedef MappedRecord<Key, Value> Record;
+
+    MappedTree();
+    explicit MappedTree(const std::string& path);
+    ~MappedTree();
+
+    void open(const std::string& path);
+    void close();
+    bool empty() const;
+    std::size_t size() const;
+
+    static void write(const BinarySearchTree<Key, Value>& tree, const std::string& path);
+
+    /**
+    * Iterator over the records in increasing key order.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Record& operator*() const;
+        const Record* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class MappedTree<Key, Value>;
+        iterator(const Record* ptr);
+        const Record* current_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+
+    MappedTree(const MappedTree&) = delete;
+    MappedTree& operator=(const MappedTree&) = delete;
+
+private:
+    static uint64_t writeHelp(Node<Key, Value>* root, Record* records);
+    void checkLink(uint64_t index, uint64_t steps) const;
+
+    void* map_;
+    std::size_t mapLength_;
+    const MappedTreeHeader* header_;
+    const Record* records_;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the MappedTree class.
+  -----------------------------------------------
+*/
+
+template<class Key, class Value>
+MappedTree<Key, Value>::iterator::iterator() : current_(NULL)
+{
+
+}
+
+template<class Key, class Value>
+MappedTree<Key, Value>::iterator::iterator(const Record* ptr) : current_(ptr)
+{
+
+}
+
+template<class Key, class Value>
+const typename MappedTree<Key, Value>::Record&
+MappedTree<Key, Value>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class Key, class Value>
+const typename MappedTree<Key, Value>::Record*
+MappedTree<Key, Value>::iterator::operator->() const
+{
+    return current_;
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+/**
+* Records are stored in key order, so the successor is the next record.
+*/
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator&
+MappedTree<Key, Value>::iterator::operator++()
+{
+    ++current_;
+    return *this;
+}
+
+/**
+* Default constructor, nothing is mapped until open() is called.
+*/
+template<class Key, class Value>
+MappedTree<Key, Value>::MappedTree() :
+    map_(NULL), mapLength_(0), header_(NULL), records_(NULL)
+{
+
+}
+
+/**
+* Maps the tree file at path.
+*/
+template<class Key, class Value>
+MappedTree<Key, Value>::MappedTree(const std::string& path) :
+    map_(NULL), mapLength_(0), header_(NULL), records_(NULL)
+{
+    open(path);
+}
+
+template<class Key, class Value>
+MappedTree<Key, Value>::~MappedTree()
+{
+    close();
+}
+
+/**
+* Maps the file read-only and validates its header.
+* Throws std::runtime_error if the file cannot be mapped or was written
+* for different Key/Value types.
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("MappedTree: cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(MappedTreeHeader)){
+        ::close(fd);
+        throw std::runtime_error("MappedTree: " + path + " is not a tree file");
+    }
+    std::size_t length = static_cast<std::size_t>(info.st_size);
+    void* map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps the file alive, the descriptor is no longer needed
+    ::close(fd);
+    if (map == MAP_FAILED){
+        throw std::runtime_error("MappedTree: cannot map " + path + ": " + std::strerror(errno));
+    }
+
+    const MappedTreeHeader* header = static_cast<const MappedTreeHeader*>(map);
+    const char* error = NULL;
+    if (std::memcmp(header->magic, MAPPED_TREE_MAGIC, sizeof(header->magic)) != 0){
+        error = " is not a tree file";
+    }
+    else if (header->version != MAPPED_TREE_VERSION){
+        error = " has an unsupported version";
+    }
+    else if (header->keySize != sizeof(Key) || header->valueSize != sizeof(Value) ||
+             header->recordSize != sizeof(Record)){
+        error = " was written for different key/value types";
+    }
+    else if (header->count > (length - sizeof(MappedTreeHeader)) / sizeof(Record) ||
+             (header->count > 0 && header->root >= header->count)){
+        error = " is truncated";
+    }
+    if (error != NULL){
+        munmap(map, length);
+        throw std::runtime_error("MappedTree: " + path + error);
+    }
+
+    map_ = map;
+    mapLength_ = length;
+    header_ = header;
+    records_ = reinterpret_cast<const Record*>(static_cast<const char*>(map) + sizeof(MappedTreeHeader));
+}
+
+/**
+* Unmaps the file, invalidating all iterators.
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::close()
+{
+    if (map_ != NULL){
+        munmap(map_, mapLength_);
+    }
+    map_ = NULL;
+    mapLength_ = 0;
+    header_ = NULL;
+    records_ = NULL;
+}
+
+template<class Key, class Value>
+bool MappedTree<Key, Value>::empty() const
+{
+    return size() == 0;
+}
+
+template<class Key, class Value>
+std::size_t MappedTree<Key, Value>::size() const
+{
+    return header_ == NULL ? 0 : static_cast<std::size_t>(header_->count);
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator
+MappedTree<Key, Value>::begin() const
+{
+    return iterator(records_);
+}
+
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator
+MappedTree<Key, Value>::end() const
+{
+    return iterator(records_ + size());
+}
+
+/**
+* Returns an iterator to the record with the given key, or end().
+*/
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator
+MappedTree<Key, Value>::find(const Key& key) const
+{
+    uint64_t index = empty() ? MAPPED_TREE_NIL : header_->root;
+    for (uint64_t steps = 0; index != MAPPED_TREE_NIL; ++steps){
+        checkLink(index, steps);
+        const Record& record = records_[index];
+        if (key < record.first){
+            index = record.left;
+        }
+        else if (record.first < key){
+            index = record.right;
+        }
+        else {
+            return iterator(&record);
+        }
+    }
+    return end();
+}
+
+/**
+* Returns an iterator to the first record whose key is not less than key,
+* or end() if there is none.
+*/
+template<class Key, class Value>
+typename MappedTree<Key, Value>::iterator
+MappedTree<Key, Value>::lower_bound(const Key& key) const
+{
+    const Record* candidate = records_ + size();
+    uint64_t index = empty() ? MAPPED_TREE_NIL : header_->root;
+    for (uint64_t steps = 0; index != MAPPED_TREE_NIL; ++steps){
+        checkLink(index, steps);
+        const Record& record = records_[index];
+        if (record.first < key){
+            index = record.right;
+        }
+        else {
+            candidate = &record;
+            index = record.left;
+        }
+    }
+    return iterator(candidate);
+}
+
+/**
+* find()/lower_bound() helper function
+* open() only validates the root, so each step checks the link it follows.
+* A path through n records is at most n steps long, a longer one has a
+* cycle. Throws std::runtime_error for either.
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::checkLink(uint64_t index, uint64_t steps) const
+{
+    if (index >= header_->count || steps >= header_->count){
+        throw std::runtime_error("MappedTree: corrupt child link");
+    }
+}
+
+/**
+* Writes tree (typically an AVLTree) to path in the mapped layout.
+* The file is built as path + ".tmp", sized up front and filled through a
+* writable mapping, synced, and then renamed over path. Processes that
+* have the old file mapped keep reading its inode, unchanged, until they
+* reopen path.
+* Throws std::runtime_error on I/O errors (path is then left as it was).
+*/
+template<class Key, class Value>
+void MappedTree<Key, Value>::write(const BinarySearchTree<Key, Value>& tree, const std::string& path)
+{
+    uint64_t count = tree.size();
+    std::size_t length = sizeof(MappedTreeHeader) + static_cast<std::size_t>(count) * sizeof(Record);
+    std::string temp = path + ".tmp";
+
+    int fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0){
+        throw std::runtime_error("MappedTree: cannot create " + temp + ": " + std::strerror(errno));
+    }
+    const char* failed = NULL;
+    std::string reason;
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0){
+        failed = "cannot size ";
+        reason = std::strerror(errno);
+    }
+    else if ((map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED){
+        failed = "cannot map ";
+        reason = std::strerror(errno);
+    }
+    else {
+        MappedTreeHeader* header = static_cast<MappedTreeHeader*>(map);
+        std::memset(header, 0, sizeof(MappedTreeHeader));
+        std::memcpy(header->magic, MAPPED_TREE_MAGIC, sizeof(header->magic));
+        header->version = MAPPED_TREE_VERSION;
+        header->keySize = sizeof(Key);
+        header->valueSize = sizeof(Value);
+        header->recordSize = sizeof(Record);
+        header->count = count;
+
+        Record* records = reinterpret_cast<Record*>(static_cast<char*>(map) + sizeof(MappedTreeHeader));
+        header->root = writeHelp(tree.root_, records);
+
+        if (msync(map, length, MS_SYNC) != 0 || fsync(fd) != 0){
+            failed = "cannot write ";
+            reason = std::strerror(errno);
+        }
+        munmap(map, length);
+    }
+    ::close(fd);
+    if (failed == NULL && std::rename(temp.c_str(), path.c_str()) != 0){
+        failed = "cannot replace ";
+        reason = std::strerror(errno);
+    }
+    if (failed != NULL){
+        ::unlink(temp.c_str());
+        throw std::runtime_error("MappedTree: " + std::string(failed) + path + ": " + reason);
+    }
+}
+
+/**
+* write() helper, numbers the nodes in order and fills in their records.
+* Iterative in-order walk with an explicit stack, so a degenerate tree does
+* not recurse once per level. A node's index is only known when it is
+* visited: a right child's index goes straight into its parent's record,
+* a left child's is kept in its parent's stack entry (the parent is on top
+* of the stack when the left child is visited).
+* Returns the index of root's record (MAPPED_TREE_NIL for an empty tree).
+*/
+template<class Key, class Value>
+uint64_t MappedTree<Key, Value>::writeHelp(Node<Key, Value>* root, Record* records)
+{
+    struct Pending
+    {
+        Node<Key, Value>* node;
+        // where the node's index goes, NULL for a left child
+        uint64_t* slot;
+        // index of the node's left child
+        uint64_t left;
+    };
+    std::vector<Pending> stack;
+    uint64_t rootIndex = MAPPED_TREE_NIL;
+    uint64_t next = 0;
+
+    Node<Key, Value>* current = root;
+    uint64_t* slot = &rootIndex;
+    while (current != NULL || !stack.empty()){
+        // push current and its chain of left children
+        for (; current != NULL; current = current->getLeft(), slot = NULL){
+            Pending pending = { current, slot, MAPPED_TREE_NIL };
+            stack.push_back(pending);
+        }
+        Pending visit = stack.back();
+        stack.pop_back();
+
+        uint64_t index = next++;
+        Record& record = records[index];
+        std::memset(static_cast<void*>(&record), 0, sizeof(Record));
+        std::memcpy(static_cast<void*>(&record.first), &visit.node->getKey(), sizeof(Key));
+        std::memcpy(static_cast<void*>(&record.second), &visit.node->getValue(), sizeof(Value));
+        record.left = visit.left;
+        record.right = MAPPED_TREE_NIL;
+        if (visit.slot != NULL) *visit.slot = index;
+        else stack.back().left = index;
+
+        current = visit.node->getRight();
+        slot = &record.right;
+    }
+    return rootIndex;
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the MappedTree class.
+  ---------------------------------------------
+*/
+
+#endif
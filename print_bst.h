@@ -130,14 +130,14 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
     std::map<Key, uint8_t> valuePlaceholders;
 
     uint8_t nextPlaceHolderVal = 1;
-    for(typename BinarySearchTree<Key, Value>::iterator treeIter = this->begin(); treeIter != this->end(); ++treeIter)
+    for(Node<Key, Value>* treeNode = getSmallestNode(); treeNode != nullptr; treeNode = successor(treeNode))
     {
 
-        if(getNodeDepth(*this, root, treeIter.current_) != -1)
+        if(getNodeDepth(*this, root, treeNode) != -1)
         {
-            // note; the iterator will traverse in sorted order so values should get the same placeholders between
+            // note; the loop will traverse in sorted order so values should get the same placeholders between
             // different calls as long as the tree is the same
-            valuePlaceholders.insert(std::make_pair(treeIter->first, nextPlaceHolderVal++));
+            valuePlaceholders.insert(std::make_pair(treeNode->getKey(), nextPlaceHolderVal++));
         }
 
     }
@@ -167,7 +167,7 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
             }
             else
             {
-                uint16_t placeholder = valuePlaceholders[currRowNodes[elementIndex]->getItem().first];
+                uint16_t placeholder = valuePlaceholders[currRowNodes[elementIndex]->getKey()];
                 std::cout << "[" << std::setfill('0') << std::setw(2) << placeholder << "]";
             }
 
@@ -273,14 +273,14 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
             std::cout.flags(origCoutState);
             std::cout << '(' << placeholdersIter->first << ", ";
 
-            typename BinarySearchTree<Key, Value>::iterator elementIter = this->find(placeholdersIter->first);
-            if(elementIter == this->end())
+            Node<Key, Value>* elementNode = this->internalFind(placeholdersIter->first);
+            if(elementNode == nullptr)
             {
                 std::cout << "<error: lookup failed>";
             }
             else
             {
-                std::cout << elementIter->second;
+                std::cout << elementNode->getValue();
             }
 
             std::cout << ')' << std::endl;
@@ -0,0 +1,213 @@
+#ifndef SCAPEGOAT_H
+#define SCAPEGOAT_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <cstddef>
+#include <cmath>
+#include "bst.h"
+
+/**
+* A scapegoat tree: a self-balancing binary search tree that uses the plain
+* Node from bst.h, so it costs no more memory per node than a BinarySearchTree.
+*
+* Instead of storing balance data in every node, it only tracks the tree size
+* (and the largest size since the last full rebuild). Whenever an insert lands
+* deeper than log_{3/2}(size), the closest ancestor whose subtree is badly
+* unbalanced (the "scapegoat") is rebuilt in place into a perfectly balanced
+* subtree. Removes that shrink the tree below 2/3 of its peak size rebuild the
+* whole tree. Heights stay within log_{3/2}(n) + 1 and updates are amortized
+* O(log n).
+*/
+template <typename Key, typename Value>
+class ScapegoatTree : public BinarySearchTree<Key, Value>
+{
+public:
+    ScapegoatTree();
+    ScapegoatTree(const ScapegoatTree<Key, Value>& other);
+    virtual void assign(const BinarySearchTree<Key, Value>& other, bool parallel = false);
+    virtual void rebalance();
+
+protected:
+    virtual Node<Key, Value>* findOrInsert(const Key& key, const Value& value,
+                                           Node<Key, Value>* detached, bool& inserted);
+    virtual void detachNode(Node<Key, Value>* target);
+
+    // Add helper functions here
+    std::size_t subtreeSize(Node<Key, Value>* current) const;
+    int depthLimit() const;
+
+protected:
+    // largest size_ since the tree was last rebuilt from the root
+    std::size_t maxSize_;
+};
+
+/*
+  -----------------------------------------------
+  Begin implementations for the ScapegoatTree class.
+  -----------------------------------------------
+*/
+
+/**
+* Default constructor, starts with an empty tree.
+*/
+template<class Key, class Value>
+ScapegoatTree<Key, Value>::ScapegoatTree() :
+    BinarySearchTree<Key, Value>(), maxSize_(0)
+{
+
+}
+
+/**
+* Copies other node for node (see BinarySearchTree::assign()).
+*/
+template<class Key, class Value>
+ScapegoatTree<Key, Value>::ScapegoatTree(const ScapegoatTree<Key, Value>& other) :
+    BinarySearchTree<Key, Value>(), maxSize_(0)
+{
+    assign(other);
+}
+
+/**
+* Copies other like BinarySearchTree::assign(); the copy counts as freshly
+* rebuilt, so its peak size starts at its size. Another kind of tree (say a
+* degenerate BinarySearchTree), or a scapegoat tree that sits deeper than
+* the copy's smaller peak size allows, is rebuilt after copying so the
+* height bound holds from the start.
+*/
+template<class Key, class Value>
+void ScapegoatTree<Key, Value>::assign(const BinarySearchTree<Key, Value>& other, bool parallel)
+{
+    BinarySearchTree<Key, Value>::assign(other, parallel);
+    maxSize_ = this->size_;
+    if (dynamic_cast<const ScapegoatTree<Key, Value>*>(&other) == nullptr ||
+        this->height() - 1 > depthLimit()){
+        this->rebuildSubtree(this->root_);
+    }
+}
+
+/**
+* Finds key or inserts it like a BinarySearchTree (for the inserts, upsert()
+* and operator[]), then rebuilds the scapegoat subtree if the new node
+* ended up too deep. Rebuilding relinks nodes without moving items, so the
+* returned node stays valid.
+*/
+template<class Key, class Value>
+Node<Key, Value>* ScapegoatTree<Key, Value>::findOrInsert(const Key& key, const Value& value,
+                                                          Node<Key, Value>* detached, bool& inserted)
+{
+    inserted = true;
+    if (this->empty()){
+        this->root_ = this->makeNode(key, value, NULL, detached);
+        this->noteAttached(this->root_);
+        this->size_ = 1;
+        maxSize_ = std::max(maxSize_, this->size_);
+        return this->root_;
+    }
+
+    // single descent, counting the depth of the new node
+    Node<Key, Value>* parent = NULL;
+    Node<Key, Value>* current = this->root_;
+    int depth = 0;
+    while (current != NULL){
+        BST_STAT((++this->stats_.nodesVisited, this->stats_.comparisons += 2));
+        if (key < current->getKey()){
+            parent = current;
+            current = current->getLeft();
+        }
+        else if (current->getKey() < key){
+            parent = current;
+            current = current->getRight();
+        }
+        else {
+            inserted = false;
+            return current;
+        }
+        ++depth;
+    }
+
+    Node<Key, Value>* newnode = this->makeNode(key, value, parent, detached);
+    if (key < parent->getKey()){
+        parent->setLeft(newnode);
+    }
+    else {
+        parent->setRight(newnode);
+    }
+    this->noteAttached(newnode);
+    ++this->size_;
+    maxSize_ = std::max(maxSize_, this->size_);
+
+    if (depth <= depthLimit()) return newnode;
+
+    // too deep: walk up to the first ancestor whose child holds more than
+    // 2/3 of its subtree, and rebuild that ancestor's subtree
+    Node<Key, Value>* child = newnode;
+    std::size_t childSize = 1;
+    Node<Key, Value>* ancestor = parent;
+    while (ancestor != NULL){
+        Node<Key, Value>* sibling =
+            (ancestor->getLeft() == child) ? ancestor->getRight() : ancestor->getLeft();
+        std::size_t ancestorSize = childSize + 1 + subtreeSize(sibling);
+        if (3 * childSize > 2 * ancestorSize){
+            this->rebuildSubtree(ancestor);
+            return newnode;
+        }
+        child = ancestor;
+        childSize = ancestorSize;
+        ancestor = ancestor->getParent();
+    }
+    return newnode;
+}
+
+/**
+* Unlinks like a BinarySearchTree (for the removes and extract()),
+* then rebuilds the whole tree once it has shrunk below 2/3 of its peak size.
+*/
+template<class Key, class Value>
+void ScapegoatTree<Key, Value>::detachNode(Node<Key, Value>* target)
+{
+    BinarySearchTree<Key, Value>::detachNode(target);
+    if (3 * this->size_ < 2 * maxSize_){
+        this->rebuildSubtree(this->root_);
+        maxSize_ = this->size_;
+    }
+}
+
+/**
+* Rebuilds the whole tree (see BinarySearchTree::rebalance), which also
+* resets the peak size used to trigger rebuilds on remove.
+*/
+template<class Key, class Value>
+void ScapegoatTree<Key, Value>::rebalance()
+{
+    BinarySearchTree<Key, Value>::rebalance();
+    maxSize_ = this->size_;
+}
+
+/**
+* Counts the nodes in the subtree rooted at current.
+*/
+template<class Key, class Value>
+std::size_t ScapegoatTree<Key, Value>::subtreeSize(Node<Key, Value>* current) const
+{
+    if (current == NULL) return 0;
+    return 1 + subtreeSize(current->getLeft()) + subtreeSize(current->getRight());
+}
+
+/**
+* Deepest depth (root = 0) a node may sit at: floor(log_{3/2}(size)).
+*/
+template<class Key, class Value>
+int ScapegoatTree<Key, Value>::depthLimit() const
+{
+    return static_cast<int>(std::log(static_cast<double>(this->size_)) / std::log(1.5));
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the ScapegoatTree class.
+  ---------------------------------------------
+*/
+
+#endif